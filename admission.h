@@ -0,0 +1,182 @@
+/**************************    admission.h    ***************************
+*
+* Programmer:       Sean Anderson
+*
+* School:           University of Houston - Clear Lake
+*
+* Course:           CSCI 4354 - Operating Systems
+*
+* Environment:      Unix with GNU C Compiler
+*
+* Files Included:   cpu_scheduler.c, admission.h
+*
+* Purpose:          Header file which contains the admission policies used when
+*                   a batch of PCBs arrives together. Given the pages each PCB
+*                   needs and the free pages available, a policy picks which of
+*                   them to admit:
+*                       fifo      in arrival order, admitting each PCB that fits
+*                       smallest  fewest pages first
+*                       maxcount  as many PCBs as smallest, but preferring
+*                                 earlier arrivals among the sets of that size
+*
+***********************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef ADMISSION_H
+#define ADMISSION_H
+
+#define ADMIT_FIFO 0
+#define ADMIT_SMALLEST 1
+#define ADMIT_MAXCOUNT 2
+
+static const char *admission_policy_names[] = { "fifo", "smallest", "maxcount" };
+
+// Returns the policy named name, or -1 if there is none.
+int parseAdmissionPolicy(const char *name)
+{
+    int i;
+    for (i = 0; i <= ADMIT_MAXCOUNT; i++)
+    {
+        if (strcmp(name, admission_policy_names[i]) == 0)
+        {
+            return i;
+        }
+    }
+    return -1;
+}
+
+// Returns the name of policy, or "none" for one PCB at a time.
+const char *admissionPolicyName(int policy)
+{
+    return (policy >= 0 && policy <= ADMIT_MAXCOUNT) ? admission_policy_names[policy] : "none";
+}
+
+// Orders batch indexes by pages needed, keeping arrival order on ties
+const long long *sort_pages;
+int comparePages(const void *a, const void *b)
+{
+    int i = *(const int*)a, j = *(const int*)b;
+    if (sort_pages[i] != sort_pages[j])
+    {
+        return (sort_pages[i] > sort_pages[j]) - (sort_pages[i] < sort_pages[j]);
+    }
+    return i - j;
+}
+
+/* Adds count PCBs needing pages pages each at sorted rank (0 based) to the
+*  Fenwick trees counts and sums over n ranks. count may be negative.
+*/
+void addRankedPages(int *counts, long long *sums, int n, int rank, int count, long long pages)
+{
+    for (rank++; rank <= n; rank += rank & -rank)
+    {
+        counts[rank] += count;
+        sums[rank] += pages;
+    }
+}
+
+/* Returns the pages needed by the want lowest-ranked PCBs in the Fenwick
+*  trees counts and sums over n ranks, or -1 if fewer than want are there.
+*  top is the highest power of 2 not above n.
+*/
+long long smallestRankedPages(const int *counts, const long long *sums, int n, int top, int want)
+{
+    long long total = 0;
+    int position = 0, step;
+    for (step = top; step > 0; step >>= 1)
+    {
+        if (position + step <= n && counts[position + step] <= want)
+        {
+            position += step;
+            want -= counts[position];
+            total += sums[position];
+        }
+    }
+    return (want == 0) ? total : -1;
+}
+
+/* Chooses which of count PCBs to admit, where PCB i needs pages[i] pages and
+*  capacity pages are free, under the given policy. Sets admit[i] to 1 for
+*  each PCB admitted and 0 otherwise. Returns the number admitted.
+*/
+int selectAdmissions(const long long *pages, int count, long long capacity, int policy, char *admit)
+{
+    int i, k, admitted = 0;
+    long long used = 0;
+    memset(admit, 0, count);
+    if (policy == ADMIT_FIFO)
+    {
+        for (i = 0; i < count; i++)
+        {
+            if (used + pages[i] <= capacity)
+            {
+                admit[i] = 1;
+                used += pages[i];
+                admitted++;
+            }
+        }
+        return admitted;
+    }
+
+    int *order = (int*)malloc((count > 0 ? count : 1) * sizeof(int));
+    for (i = 0; i < count; i++)
+    {
+        order[i] = i;
+    }
+    sort_pages = pages;
+    qsort(order, count, sizeof(int), comparePages);
+
+    // Taking the smallest first admits the most PCBs possible
+    for (k = 0; k < count && used + pages[order[k]] <= capacity; k++)
+    {
+        used += pages[order[k]];
+    }
+    if (policy == ADMIT_SMALLEST)
+    {
+        for (i = 0; i < k; i++)
+        {
+            admit[order[i]] = 1;
+        }
+        free(order);
+        return k;
+    }
+
+    // Walk in arrival order, admitting a PCB whenever the cheapest way to
+    // finish with k PCBs after taking it still fits. The PCBs after it are
+    // kept in Fenwick trees over their sorted rank, so the cheapest ones are
+    // found in O(log count).
+    int *rank = (int*)malloc((count > 0 ? count : 1) * sizeof(int));
+    int *counts = (int*)calloc(count + 1, sizeof(int));
+    long long *sums = (long long*)calloc(count + 1, sizeof(long long));
+    int top = 1;
+    while (top * 2 <= count)
+    {
+        top *= 2;
+    }
+    for (i = 0; i < count; i++)
+    {
+        rank[order[i]] = i;
+        addRankedPages(counts, sums, count, i, 1, pages[order[i]]);
+    }
+    used = 0;
+    for (i = 0; i < count && admitted < k; i++)
+    {
+        addRankedPages(counts, sums, count, rank[i], -1, -pages[i]);
+        long long rest = smallestRankedPages(counts, sums, count, top, k - admitted - 1);
+        if (rest >= 0 && used + pages[i] + rest <= capacity)
+        {
+            admit[i] = 1;
+            used += pages[i];
+            admitted++;
+        }
+    }
+    free(order);
+    free(rank);
+    free(counts);
+    free(sums);
+    return admitted;
+}
+
+#endif
@@ -0,0 +1,228 @@
+/**************************    completion_log.h    ***************************
+*
+* Programmer:       Sean Anderson
+*
+* School:           University of Houston - Clear Lake
+*
+* Course:           CSCI 4354 - Operating Systems
+*
+* Environment:      Unix with GNU C Compiler
+*
+* Files Included:   cpu_scheduler.c, log_reader.c, completion_log.h
+*
+* Purpose:          Header file which contains the CompletionLog, an append-only
+*                   file of fixed-size LogRecords, one for every PCB which leaves
+*                   the scheduler (completed, rejected or cancelled). The file is
+*                   memory mapped, so appending is a store into the page cache
+*                   and never waits on the disk. The file is doubled with
+*                   ftruncate and mremap once it is half full, between clocks
+*                   (prepareCompletionLog), so an append only has to grow it
+*                   itself if a single clock fills the other half. The header
+*                   count is bumped only after a record is written, so a reader
+*                   never sees a partial record.
+*
+* Log File:         LogHeader (64 bytes), then count LogRecords (48 bytes each).
+*
+***********************************************************************/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+
+#ifndef COMPLETION_LOG_H
+#define COMPLETION_LOG_H
+
+#define LOG_MAGIC 0x474C4350 // "PCLG"
+#define LOG_VERSION 2
+#define LOG_INITIAL_RECORDS 4096
+
+// Outcomes recorded for a PCB
+#define LOG_COMPLETED 0
+#define LOG_REJECTED 1
+#define LOG_CANCELLED 2
+
+typedef struct log_header
+{
+    int magic;
+    int version;
+    int record_size;
+    int reserved;
+    long long count;
+    long long unused[5];    // Pads the header to 64 bytes
+} LogHeader;
+
+typedef struct log_record
+{
+    int pcbnumber;
+    int outcome;
+    int arrival;            // Clock the PCB was received
+    int firstDispatch;      // Clock it first ran, or -1 if it never did
+    int end;                // Clock it left the scheduler
+    int burst;              // Total CPU burst
+    long long pages;
+    long long fragmentation;
+    int groupId;
+    int wait;               // Clocks it spent in ready queues
+} LogRecord;
+
+typedef struct completion_log
+{
+    int fd;
+    char *base;             // Mapping of the whole file
+    size_t mapped_bytes;
+    long long capacity;     // Records that fit in the mapping
+} CompletionLog;
+
+// Returns the file size needed to hold records LogRecords.
+size_t logFileSize(long long records)
+{
+    return sizeof(LogHeader) + (size_t)records * sizeof(LogRecord);
+}
+
+/* Returns 1 if a header claiming count records fits a file of file_size
+*  bytes. The count is bounded before any size is computed from it, so a
+*  corrupt or negative count cannot wrap logFileSize.
+*/
+int logCountFits(long long count, off_t file_size)
+{
+    return file_size >= (off_t)sizeof(LogHeader) && count >= 0 &&
+        (unsigned long long)count <= (unsigned long long)(file_size - sizeof(LogHeader)) / sizeof(LogRecord);
+}
+
+/* Opens the log at path for appending, creating it if needed. Records in an
+*  existing log are kept. Returns NULL if the file cannot be used.
+*/
+CompletionLog* openCompletionLog(const char *path)
+{
+    int fd = open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) < 0)
+    {
+        perror("Unable to open completion log");
+        if (fd >= 0) close(fd);
+        return NULL;
+    }
+
+    LogHeader existing;
+    long long count = 0;
+    if (st.st_size > 0)
+    {
+        if (pread(fd, &existing, sizeof(LogHeader), 0) != sizeof(LogHeader) ||
+            existing.magic != LOG_MAGIC || existing.version != LOG_VERSION ||
+            existing.record_size != (int)sizeof(LogRecord) ||
+            !logCountFits(existing.count, st.st_size))
+        {
+            printf("Completion log %s is not compatible.\n", path);
+            close(fd);
+            return NULL;
+        }
+        count = existing.count;
+    }
+
+    long long capacity = LOG_INITIAL_RECORDS;
+    while (capacity < count + 1)
+    {
+        capacity *= 2;
+    }
+    size_t bytes = logFileSize(capacity);
+    if (ftruncate(fd, bytes) < 0)
+    {
+        perror("Unable to size completion log");
+        close(fd);
+        return NULL;
+    }
+    char *base = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (base == MAP_FAILED)
+    {
+        perror("Unable to map completion log");
+        close(fd);
+        return NULL;
+    }
+
+    LogHeader *h = (LogHeader*)base;
+    if (count == 0)
+    {
+        memset(h, 0, sizeof(LogHeader));
+        h->magic = LOG_MAGIC;
+        h->version = LOG_VERSION;
+        h->record_size = sizeof(LogRecord);
+    }
+    CompletionLog *L = (CompletionLog*)malloc(sizeof(CompletionLog));
+    L->fd = fd;
+    L->base = base;
+    L->mapped_bytes = bytes;
+    L->capacity = capacity;
+    return L;
+}
+
+/* Doubles the file and mapping of log L. Returns 0, or -1 if it cannot grow.
+*/
+int growCompletionLog(CompletionLog *L)
+{
+    size_t bytes = logFileSize(L->capacity * 2);
+    char *base;
+    if (ftruncate(L->fd, bytes) < 0 ||
+        (base = mremap(L->base, L->mapped_bytes, bytes, MREMAP_MAYMOVE)) == MAP_FAILED)
+    {
+        perror("Unable to grow completion log");
+        return -1;
+    }
+    L->base = base;
+    L->mapped_bytes = bytes;
+    L->capacity *= 2;
+    return 0;
+}
+
+/* Grows log L ahead of need once it is half full. Called between clocks, so
+*  appends made during a clock do not wait for the file to grow.
+*/
+void prepareCompletionLog(CompletionLog *L)
+{
+    if (L != NULL && ((LogHeader*)L->base)->count >= L->capacity / 2)
+    {
+        growCompletionLog(L);
+    }
+}
+
+/* Appends record r to log L, growing it first only if it is still full.
+*  Returns 0, or -1 if the log could not grow (the record is dropped).
+*/
+int appendCompletionLog(CompletionLog *L, LogRecord *r)
+{
+    LogHeader *h = (LogHeader*)L->base;
+    if (h->count == L->capacity)
+    {
+        if (growCompletionLog(L) < 0)
+        {
+            return -1;
+        }
+        h = (LogHeader*)L->base;
+    }
+    LogRecord *records = (LogRecord*)(L->base + sizeof(LogHeader));
+    records[h->count] = *r;
+    __atomic_store_n(&h->count, h->count + 1, __ATOMIC_RELEASE);
+    return 0;
+}
+
+/* Unmaps and closes log L, trimming the file to the records written. The
+*  kernel writes the dirty pages back in its own time.
+*/
+void closeCompletionLog(CompletionLog *L)
+{
+    long long count = ((LogHeader*)L->base)->count;
+    msync(L->base, L->mapped_bytes, MS_ASYNC);
+    munmap(L->base, L->mapped_bytes);
+    if (ftruncate(L->fd, logFileSize(count)) < 0)
+    {
+        perror("Unable to trim completion log");
+    }
+    close(L->fd);
+    free(L);
+}
+
+#endif
@@ -12,20 +12,90 @@
 *
 * Environment:      Unix with GNU C Compiler
 *
-* Files Included:   cpu_scheduler.c, pcb_client.c, pcb_structs.h, mem_structs.h
+* Files Included:   cpu_scheduler.c, pcb_client.c, pcb_structs.h, mem_structs.h,
+*                   snapshot.h, quantum_tuner.h, sweep.h, timing_wheel.h, pcb_index.h,
+*                   fair_share.h, real_process.h, admission.h, completion_log.h,
+*                   realtime.h, perf_counters.h, shard_load.h
 *
 * Purpose:          To start simulate a CPU Scheduler. The program will receive PCBs
 *                   via a common FIFO which contain the burst time and amount of 
 *                   memory allocation required to perform the task. The CPU Scheduler
 *                   will confirm that there is sufficient memory available, allocate
 *                   the appropriate amount of memory pagefiles and then complete each
-*                   task according to a round-robin scheduling algorithm.
+*                   task according to a round-robin scheduling algorithm. A PCB may
+*                   alternate CPU and I/O bursts; while it waits on I/O it is held in
+*                   a blocked set (timing wheel) and other PCBs use the CPU.
 *
 * Input:            (2) Parameters, total memory size and page file size, each passed
 *                   as parameters when program is run. Program will default to 1024 and
-*                   64 respectively if no parameters are passed. 
+*                   64 respectively if no parameters are passed. Sizes are 64-bit and
+*                   accept K, M, G and T suffixes (e.g. 64G).
 *
 *                   Receives PCBs from PCB_Client program via fifo named cpu_fifo.
+*                   A PCB may instead be a query or cancel request for another PCB,
+*                   which is answered through the requester's fifo.
+*
+*                   Optional: -s snapshot_file. On shutdown the scheduler state is
+*                   saved to snapshot_file instead of returning queued PCBs to their
+*                   clients, and is restored from it on the next start.
+*
+*                   Optional: -a percentile [-i interval]. Adaptive quantum mode.
+*                   Every interval clocks (default 10) the round-robin quantum is
+*                   retuned to the given percentile of the observed burst times.
+*
+*                   Optional: -c switch_cost [-r resume_cost]. Context-switch cost
+*                   model. Each switch to a different PCB costs switch_cost clocks,
+*                   plus resume_cost clocks if that PCB has run before and another
+*                   PCB has run since (cold caches and TLB).
+*
+*                   Optional: -W workload_file [-M sizes] [-P sizes] [-R quanta] [-j jobs].
+*                   Sweep mode. Instead of serving cpu_fifo, runs the workload once
+*                   for every combination of the comma separated total memory sizes,
+*                   page sizes and quanta, each in its own process, up to jobs at a
+*                   time (default: all cores), and prints one CSV row per run.
+*
+*                   Optional: -g group:weight[:memory_quota],... Fair-share mode.
+*                   Each client group gets its own ready queue and CPU time is split
+*                   between groups in proportion to their weights (stride scheduling).
+*                   A group with a quota may not hold more pages than fit in it.
+*                   Groups not listed have weight 1 and no quota.
+*
+*                   Optional: -x tick_ms. Real-process mode. A PCB submitted with a
+*                   command has that command run as a real process, limited to its
+*                   memoryNeeded (plus a base for the program image) with RLIMIT_AS,
+*                   and time-sliced with SIGCONT/SIGSTOP on a tick_ms clock. Its burst
+*                   is a CPU limit in clocks; it is killed if it runs past it.
+*                   With -n, the commands which exited are run again at shutdown
+*                   under plain nice, as a baseline for the scheduler's overhead.
+*                   Each one then runs twice, side effects and all.
+*
+*                   Optional: -b policy. Batch admission. Every PCB waiting in
+*                   cpu_fifo is read each clock and the batch is admitted together:
+*                   the policy (fifo, smallest or maxcount) picks which PCBs get
+*                   memory, and all of their pages are carved out in one pass.
+*
+*                   Optional: -u max_utilization. Real-time class. A PCB submitted
+*                   with a deadline is run earliest-deadline-first ahead of all
+*                   best-effort work, preempting it on arrival. It is admitted only
+*                   if the CPU share reserved for real-time PCBs stays within
+*                   max_utilization percent, so every admitted deadline can be met.
+*
+*                   Optional: -e. Phase counters. Cycles, instructions, cache misses
+*                   and branch misses (perf_event_open, or rdtsc time where those
+*                   are unavailable) are charged to the phase of the clock cycle
+*                   they were spent in: ingest, admission, execution, dispatch,
+*                   writeback or other. Totals and per-clock distributions are
+*                   printed on shutdown.
+*
+*                   Optional: -f fifo_name [-D load_file:slot]. Serves fifo_name
+*                   instead of cpu_fifo. The dispatcher starts each of its shards
+*                   this way, with -D naming the load channel and this shard's slot
+*                   in it, where its free pages and queue depths are published
+*                   every clock.
+*
+*                   Optional: -l log_file. Appends a fixed-size record for every
+*                   PCB that completes, is rejected or is cancelled to log_file, a
+*                   memory-mapped completion log read by log_reader.
 *
 * Preconditions:    Fifo "cpu_fifo" must be successfully created and opened in order for
 *                   program to enter into service loop.
@@ -41,47 +111,96 @@
 *                   Declare currentPCB
 *                   Initialize Ready_Queue
 *                   Initialize Memory_Queue
+*                   If a snapshot file is given and exists, restore the ready queue,
+*                       running PCB, memory, clock and statistics from it
 *                   Make Fifo cpu_fifo
 *                   Open FIFO cpu_fifo in Read-Only Mode
 *
 *                   ** MAIN LOOP **
 *                   Print current value of cpu_clock
 *                   Sleep for 2 seconds (to allow pcb_clients to connect and write)
+*                   Move PCBs whose I/O burst completes this clock from the blocked
+*                       set to the ready queue
 *
 *                   PART I
-*                   Try to read new PCB from cpu_fifo
+*                   Try to read new PCB from cpu_fifo (sweep mode: take every
+*                       workload PCB arriving at this clock; batch mode: read
+*                       every waiting PCB, choose the admission set by policy
+*                       and allocate all of its memory in one pass)
+*                       If it is a query, look up the target PCB in the pcb_index and
+*                           reply with its state
+*                       If it is a cancel, look up the target PCB in the pcb_index,
+*                           unlink it, return its memory, return it to its sender
+*                           and reply with the number of pages released
 *                       If read, try to allocate memory
+*                           If its group would exceed its page quota, fail
+*                           If it has a deadline and reserving its CPU share would
+*                               exceed the real-time capacity, fail
+*                           If it names a command, fork it stopped under its RLIMIT_AS
 *                           If success, add PCB to ready queue and print PCB details
+*                               (fair-share mode: its group's ready queue; with a
+*                               deadline: the EDF queue)
 *                           If fail, write failed PCB back to sender
 *
-*                   Increase time_waiting_in_ready by the ready_queue size
+*                   If adaptive quantum mode is on and a retune interval has passed
+*                       Set round_robin_max to the target percentile burst estimate
 *
 *                   PART II
 *                   Process PCB currently in "running" state (running_pcb)
+*                       If switch overhead remains, spend this clock on it
+*                           Decrement switch_overhead_remaining
+*                           Increment overhead_cycles
+*                           Skip to PART III
+*                       If it is a real process and has exited, it is completed
 *                       Increment active_cpu_time
-*                       Decrement remaining_burst and remaining_rr_time
+*                       Fair-share mode: advance the PCB's group pass by its stride
+*                       Decrement remaining_burst and remaining_rr_time (a real-time
+*                           PCB is not time sliced)
+*                       If a PCB is blocked on I/O meanwhile, increment io_overlap_cycles
+*                       If the CPU burst is completed and an I/O burst follows
+*                           Insert running_pcb into the blocked set until its I/O completes
+*                           Point running_pcb to NULL
+*                           Increment voluntary_preemptions
 *                       If process is completed (remaining_time = 0)
 *                           Set end_time to cpu_clock
+*                           If it has a deadline, count a miss if end_time is past it
+*                           Append its record to the completion log, if any
 *                           Increase CPU statistics (total_wait_time and total_turnaround_time)
 *                               based upon running_pcb's times, writeback to sender via pcb->fifoname
 *                           Print running_pcb details
 *                           Point running_pcb to NULL
 *                           Increment completed_tasks
+*                           Increment voluntary_preemptions
 *                       If round-robin time quantum is completed (remaining_rr_time = 0)
-*                           Enqueue current_pcb
+*                           Enqueue current_pcb (real process: SIGSTOP it first)
 *                           Point current_pcb to NULL
+*                           Increment involuntary_preemptions
 *
 *                   PART III
+*                   If the EDF queue holds a PCB with an earlier deadline than
+*                       running_pcb (best-effort PCBs have none), return running_pcb
+*                       to its ready queue (real process: SIGSTOP it first)
 *                   Check if there is still a PCB in the running state (running_pcb != NULL)
 *                       If not:
-*                           Dequeue the first PCB from the ready queue and point to it with 
-*                               current_pcb
+*                           Dequeue the PCB with the earliest deadline from the EDF
+*                               queue, or if it is empty the first PCB from the ready
+*                               queue, and point to it with current_pcb (fair-share
+*                               mode: from the group with the lowest pass)
+*                           Add the clocks since it was enqueued to its wait time;
+*                               on its first dispatch, record its response time
 *                           Set remaining_rr_time to round_robin_max
+*                           If it is not the PCB that ran last
+*                               Increment context_switches
+*                               Set switch_overhead_remaining from the cost model
+*                           If it is a real process, SIGCONT it once any switch
+*                               overhead has been paid
 *                   
 *                   ** FINAL CLEANUP **
 *                   Close and unlink "cpu_fifo"
 *                   Calculate CPU Scheduler Statistics
 *                   Print CPU Scheduler Statistics
+*                   If a snapshot file is given, save the scheduler state to it.
+*                       Otherwise, return all queued PCBs to their senders.
 *                   Free all allocated memory variables
 *                   Exit
 *
@@ -92,6 +211,7 @@
 * Testing            2.5 hr     2.0 hr
 *
 ***********************************************************************/ 
+#define _GNU_SOURCE // mremap, used by completion_log.h
 #include <stdlib.h>
 #include <stdio.h>
 #include <fcntl.h>
@@ -103,23 +223,114 @@
 #include <sys/stat.h>
 #include "pcb_structs.h"
 #include "mem_structs.h"
+#include "snapshot.h"
+#include "quantum_tuner.h"
+#include "sweep.h"
+#include "timing_wheel.h"
+#include "pcb_index.h"
+#include "fair_share.h"
+#include "real_process.h"
+#include "admission.h"
+#include "completion_log.h"
+#include "realtime.h"
+#include "perf_counters.h"
+#include "shard_load.h"
+#include "static_config.h"
 
+#ifdef SCHED_STATIC_CONFIG
+static const int round_robin_max = SCHED_QUANTUM; // Fixed when built (static_config.h)
+#else
 int round_robin_max = 4; // Sets the maximum round robin time
+#endif
 const int total_clocks = 50; // THIS VARIABLE DETERMINES TOTAL CLOCKS RUN
 
 // Initialized CPU Statistic Variables
 int cpu_clock = 0;
 int active_cpu_time = 0;
 int time_waiting_in_ready = 0;
+long long total_response_time = 0;
+int responded_tasks = 0;
 int total_turnaround_time = 0;
 int completed_tasks = 0;
+int cancelled_tasks = 0;
+int io_blocks = 0;
+int io_overlap_cycles = 0;
+int admitted_tasks = 0;
+int rejected_tasks = 0;
+long long total_fragmentation = 0;
 int remaining_rr_time = 4;
+int context_switches = 0;
+int voluntary_preemptions = 0;
+int involuntary_preemptions = 0;
+
+// Context Switch Cost Model Variables
+int switch_cost = 0;
+int resume_cost = 0;
+int switch_overhead_remaining = 0;
+int overhead_cycles = 0;
+pid_t last_run_pcb = -1;    // pcbnumber of the PCB which ran last, -1 if none
+
+// Adaptive Quantum Variables
+int adaptive_quantum = 0;
+int retune_interval = 10;
+int quantum_changes = 0;
+QuantileEstimator burst_estimator;
+
+// Sweep Mode Variables
+Workload *workload = NULL;
+int next_arrival = 0;
+SampleList turnaround_samples;
+
+// Fair-Share Mode Variables
+FairShare *fair_share = NULL;
+
+// Real-Process Mode Variables
+int real_tick_ms = 0;   // 0 when real-process mode is off
+int tick_fd = -1;
+int tick_overruns = 0;
+int real_completed = 0;
+int real_killed = 0;
+int signals_sent = 0;
+int granted_ticks = 0;
+long long child_cpu_micros = 0;
+int nice_baseline = 0;      // -n: rerun exited commands under plain nice at shutdown
+RealRun *real_runs = NULL;  // Commands which exited, for the plain nice baseline
+int real_run_count = 0;
+int real_run_capacity = 0;
+
+// Batch Admission Variables
+#ifdef SCHED_STATIC_CONFIG
+static const int admission_policy = SCHED_ADMISSION_POLICY;
+#else
+int admission_policy = -1;  // -1 admits one PCB at a time
+#endif
+PCB **arrival_batch = NULL;
+int arrival_capacity = 0;
+
+// Real-Time Class Variables
+EdfQueue *rt_q = NULL;  // NULL when the real-time class is off
+
+// Phase Counter Variables
+PerfCounters *perf = NULL;  // NULL unless -e is given
+
+// Shard Variables
+const char *fifo_name = "cpu_fifo";
+ShardLoad *shard_load = NULL;   // This shard's slot in the dispatcher's load channel
+ShardLoad shard_values;         // What is published to it
+
+// Completion Log Variables
+const char *log_path = NULL;
+CompletionLog *completion_log = NULL;
 
 // Declared CPU Scheduling Variables
 PCB *running_pcb;
 pcb_queue *rdy_q;
+TimingWheel *blocked_q;
+PCBIndex *pcb_index;
 MemQueue *mem_q;
 int fd_in;
+const char *snapshot_path = NULL;
+volatile sig_atomic_t shutdown_requested = 0;
     
 // Forward Declared Functions
 PCB* receiveNewPCB(int);
@@ -127,84 +338,428 @@ PCB* allocatePCBMemory(PCB*, MemQueue*);
 void addPCBToQueue(pcb_queue *, PCB *);
 PCB* processCurrentPCB(pcb_queue *, PCB *, MemQueue *);
 PCB* updateCurrentPCBfromReadyQueue(pcb_queue *, PCB *);    
+void runClockCycle();
+void wakeBlockedPCBs();
+void readyEnqueue(pcb_queue *, PCB *);
+void requeueReady(pcb_queue *, PCB *);
+PCB* readyDequeue(pcb_queue *);
+void recordReadyWait(PCB *);
+int readyCount(pcb_queue *);
+void regroupReadyPCBs();
+void collectReadyPCBs();
+void handleClientRequest(PCB *);
+void rebuildPCBIndex();
+void returnPCBToClient(PCB *);
+SweepResult simulateConfiguration(long long, long long, int);
 void shutDownProcedures();
+void requestShutdown(int);
+void retuneQuantum();
+int switchCost(PCB *);
+void fillSnapshotHeader(SnapshotHeader *);
+void applySnapshotHeader(SnapshotHeader *);
+void printShareGroupStatistics();
+void printRealProcessStatistics();
+void recordRealRun(PCB *);
+PCB* nextWorkloadPCB();
+int receiveArrivals();
+const char* checkNewPCB(PCB *);
+int overGroupQuota(PCB *, long long, MemQueue *);
+void reserveGroupPages(PCB *, long long);
+void rejectPCB(PCB *, const char *);
+PCB* admitPCB(PCB *, MemBlock *, MemQueue *);
+void admitPCBBatch(PCB **, int, MemQueue *, pcb_queue *);
+void logPCB(PCB *, int);
+int inRealTimeClass(PCB *);
+long long realTimeDensity(PCB *);
+int admitRealTime(PCB *);
+void preemptForDeadline();
+void printRealTimeStatistics();
+void printPhaseStatistics();
+int openShardLoad(const char *);
+void publishShardLoad();
 
 // START OF MAIN PROGRAM
 /* Run using: 
 *   ./[filename] (defaults to 1024, 64, 4)
 *   ./[filename] total_memory pagefile_size (positive integers)
 *   ./[filename] total_memory pagefile_size round_robin_quanta (positive integers)
+*   ./[filename] -s snapshot_file [total_memory pagefile_size [round_robin_quanta]]
+*   ./[filename] -a burst_percentile [-i retune_interval] [total_memory pagefile_size]
+*   ./[filename] -c switch_cost [-r resume_cost] [total_memory pagefile_size]
+*   ./[filename] -W workload_file [-M sizes] [-P sizes] [-R quanta] [-j jobs]
+*   ./[filename] -g group:weight[:memory_quota],... [total_memory pagefile_size]
+*   ./[filename] -x tick_ms [-n] [total_memory pagefile_size [round_robin_quanta]]
+*   ./[filename] -b fifo|smallest|maxcount [total_memory pagefile_size]
+*   ./[filename] -l log_file [total_memory pagefile_size [round_robin_quanta]]
+*   ./[filename] -u max_utilization [total_memory pagefile_size [round_robin_quanta]]
+*   ./[filename] -e [total_memory pagefile_size [round_robin_quanta]]
+*   ./[filename] -f fifo_name [-D load_file:slot] [total_memory pagefile_size [round_robin_quanta]]
+*
+*   total_memory and pagefile_size accept size suffixes, e.g. 64G and 4K.
+*
+*   Built with -DSCHED_STATIC_CONFIG, the memory and page sizes, quantum and
+*   admission policy are fixed (see static_config.h), so none of them, nor -a,
+*   -b, -M, -P or -R, may be given.
 */
 int main(int argc, char** argv)
 {
+    // Capture options, leaving the positional parameters in args
+    int opt;
+    const char *memory_list = NULL, *page_list = NULL, *quantum_list = NULL;
+#ifdef SCHED_STATIC_CONFIG
+    int sweep_jobs = SCHED_CORES;
+#else
+    int sweep_jobs = (int)sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+    const char *load_channel = NULL;
+    while ((opt = getopt(argc, argv, "s:a:i:c:r:W:M:P:R:j:g:x:nb:l:u:ef:D:")) != -1)
+    {
+        switch (opt)
+        {
+            case 's':
+                snapshot_path = optarg;
+                break;
+            case 'a':
+                adaptive_quantum = 1;
+                initQuantileEstimator(&burst_estimator, atof(optarg) / 100.0);
+                if (burst_estimator.percentile <= 0.0 || burst_estimator.percentile >= 1.0)
+                {
+                    printf("Burst percentile must be between 0 and 100.\n");
+                    exit(1);
+                }
+                break;
+            case 'i':
+                retune_interval = atoi(optarg);
+                if (retune_interval < 1)
+                {
+                    printf("Retune interval must be a positive integer.\n");
+                    exit(1);
+                }
+                break;
+            case 'c':
+                switch_cost = atoi(optarg);
+                break;
+            case 'r':
+                resume_cost = atoi(optarg);
+                break;
+            case 'W':
+                if ((workload = loadWorkload(optarg)) == NULL)
+                {
+                    exit(1);
+                }
+                break;
+            case 'M':
+                memory_list = optarg;
+                break;
+            case 'P':
+                page_list = optarg;
+                break;
+            case 'R':
+                quantum_list = optarg;
+                break;
+            case 'j':
+                sweep_jobs = atoi(optarg);
+                break;
+            case 'g':
+                fair_share = new_FairShare();
+                if (parseShareGroups(fair_share, optarg) < 0)
+                {
+                    printf("Groups must be listed as group:weight[:memory_quota] with positive weights.\n");
+                    exit(1);
+                }
+                break;
+            case 'b':
+#ifdef SCHED_STATIC_CONFIG
+                printf("The admission policy was fixed when this scheduler was built.\n");
+                exit(1);
+#else
+                if ((admission_policy = parseAdmissionPolicy(optarg)) < 0)
+                {
+                    printf("Admission policy must be fifo, smallest or maxcount.\n");
+                    exit(1);
+                }
+                break;
+#endif
+            case 'l':
+                log_path = optarg;
+                break;
+            case 'e':
+                perf = new_PerfCounters();
+                break;
+            case 'f':
+                fifo_name = optarg;
+                break;
+            case 'D':
+                load_channel = optarg;
+                break;
+            case 'u':
+                if (atof(optarg) <= 0.0 || atof(optarg) > 100.0)
+                {
+                    printf("Real-time utilization must be above 0 and at most 100 percent.\n");
+                    exit(1);
+                }
+                rt_q = new_EdfQueue((long long)(atof(optarg) / 100.0 * RT_PPM));
+                break;
+            case 'x':
+                real_tick_ms = atoi(optarg);
+                if (real_tick_ms < 1)
+                {
+                    printf("Tick length must be a positive number of milliseconds.\n");
+                    exit(1);
+                }
+                break;
+            case 'n':
+                nice_baseline = 1;
+                break;
+            default:
+                printf("Usage: %s [-s snapshot_file] [-a burst_percentile [-i retune_interval]]"
+                    " [-c switch_cost [-r resume_cost]]"
+                    " [-W workload_file [-M sizes] [-P sizes] [-R quanta] [-j jobs]]"
+                    " [-g group:weight[:memory_quota],...] [-x tick_ms [-n]] [-b admission_policy]"
+                    " [-l log_file] [-u max_utilization] [-e] [-f fifo_name [-D load_file:slot]]"
+                    " [total_memory pagefile_size [round_robin_quanta]]\n", argv[0]);
+                exit(1);
+        }
+    }
+#ifdef SCHED_STATIC_CONFIG
+    if (adaptive_quantum || memory_list != NULL || page_list != NULL || quantum_list != NULL || optind < argc)
+    {
+        printf("This scheduler was built for %lld bytes of memory in %lld byte pages with a quantum of %d;"
+            " -a, -M, -P, -R and sizes cannot be given.\n", SCHED_TOTAL_MEMORY, SCHED_PAGE_SIZE, SCHED_QUANTUM);
+        exit(1);
+    }
+#endif
+    if (switch_cost < 0 || resume_cost < 0)
+    {
+        printf("Switch and resume costs must be non-negative integers.\n");
+        exit(1);
+    }
+    if (log_path != NULL && workload != NULL)
+    {
+        printf("A completion log cannot be written in sweep mode.\n");
+        exit(1);
+    }
+    // Shards share a directory, so anything written to a fixed path would collide
+    if (load_channel != NULL && (snapshot_path != NULL || log_path != NULL || workload != NULL))
+    {
+        printf("A dispatcher shard cannot be combined with -s, -l or -W.\n");
+        exit(1);
+    }
+    // Counters follow this thread only, and a sweep runs in forked children
+    if (perf != NULL && workload != NULL)
+    {
+        printf("Phase counters cannot be used in sweep mode.\n");
+        exit(1);
+    }
+    // A snapshot cannot hold a live process, and a sweep never runs one
+    if (real_tick_ms > 0 && (snapshot_path != NULL || workload != NULL))
+    {
+        printf("Real-process mode cannot be combined with -s or -W.\n");
+        exit(1);
+    }
+    if (nice_baseline && real_tick_ms == 0)
+    {
+        printf("The plain nice baseline (-n) needs real-process mode (-x).\n");
+        exit(1);
+    }
+
     // Establish Signal Handler to terminate program upon Ctrl-C
-    signal(SIGINT, shutDownProcedures);
+    signal(SIGINT, requestShutdown);
     
-    // Initialize Ready_Queue
+    // Initialize Ready_Queue and blocked set
     rdy_q = new_pcb_queue();
+    blocked_q = new_TimingWheel(0);
+    pcb_index = new_PCBIndex();
 
     // Initialize MemQueue
-    int serverTotalMemory = 1024;
-    int serverPageSize = 64;
-    if(argc == 3)
+#ifdef SCHED_STATIC_CONFIG
+    long long serverTotalMemory = SCHED_TOTAL_MEMORY;
+    long long serverPageSize = SCHED_PAGE_SIZE;
+#else
+    int nargs = argc - optind;
+    char **args = argv + optind;
+    long long serverTotalMemory = 1024;
+    long long serverPageSize = 64;
+    if(nargs == 2)
+    {
+        serverTotalMemory = parseMemorySize(args[0]);
+        serverPageSize = parseMemorySize(args[1]);
+    }
+    if(nargs == 3)
     {
-        serverTotalMemory = atoi(argv[1]);
-        serverPageSize = atoi(argv[2]);
+        serverTotalMemory = parseMemorySize(args[0]);
+        serverPageSize = parseMemorySize(args[1]);
+        round_robin_max = atoi(args[2]);
     }
-    if(argc == 4)
+#endif
+
+    // Sweep mode: run the workload for every configuration and exit
+    if (workload != NULL)
     {
-        serverTotalMemory = atoi(argv[1]);
-        serverPageSize = atoi(argv[2]);
-        round_robin_max = atoi(argv[3]);
+        long long memories[MAX_SWEEP_VALUES], pages[MAX_SWEEP_VALUES];
+        int quanta[MAX_SWEEP_VALUES];
+        int num_memories = 1, num_pages = 1, num_quanta = 1;
+        memories[0] = serverTotalMemory;
+        pages[0] = serverPageSize;
+        quanta[0] = round_robin_max;
+        if ((memory_list != NULL && (num_memories = parseSizeList(memory_list, memories, MAX_SWEEP_VALUES)) < 1) ||
+            (page_list != NULL && (num_pages = parseSizeList(page_list, pages, MAX_SWEEP_VALUES)) < 1) ||
+            (quantum_list != NULL && (num_quanta = parseQuantumList(quantum_list, quanta, MAX_SWEEP_VALUES)) < 1))
+        {
+            printf("Sweep lists must be comma separated positive values, with quanta plain integers.\n");
+            exit(1);
+        }
+        if (sweep_jobs < 1)
+        {
+            sweep_jobs = 1;
+        }
+        return runSweep(memories, num_memories, pages, num_pages, quanta, num_quanta,
+            sweep_jobs, simulateConfiguration) == 0 ? 0 : 1;
     }
     mem_q = new_MemQueue(serverTotalMemory, serverPageSize); 
+
+    // Restore the previous run's state if a snapshot was left behind
+    SnapshotHeader snapshot;
+    if (snapshot_path != NULL && loadSnapshot(snapshot_path, &snapshot, &running_pcb, rdy_q, blocked_q, &mem_q) == 0)
+    {
+        applySnapshotHeader(&snapshot);
+        rebuildPCBIndex();
+        regroupReadyPCBs();
+        serverTotalMemory = mem_q->total_size;
+        serverPageSize = MEM_PAGE_SIZE(mem_q);
+        printf("Restored snapshot %s at CPU Time %d: %d PCBs ready, %d blocked, %s\n", snapshot_path,
+            cpu_clock, readyCount(rdy_q), blocked_q->size, running_pcb != NULL ? "1 running" : "none running");
+    }
     
     // Print Initial Server Settings
     printf("\n----- Starting CPU Scheduler -----\n");
     printf("Server Duration: %d\n", total_clocks);
-    printf("Total Memory: %d\n", serverTotalMemory);
-    printf("Pagefile Size: %d\n", serverPageSize);
+    printf("Total Memory: %lld\n", serverTotalMemory);
+    printf("Pagefile Size: %lld\n", serverPageSize);
+    if (adaptive_quantum)
+    {
+        printf("Round Robin Quantum: adaptive, p%g burst every %d clocks (starting at %d)\n",
+            burst_estimator.percentile * 100.0, retune_interval, round_robin_max);
+    }
+    else
+    {
+        printf("Round Robin Quantum: %d\n", round_robin_max);
+    }
+#ifdef SCHED_STATIC_CONFIG
+    printf("Static Configuration: memory, pages, quantum and admission policy fixed at build time\n");
+#endif
+    if (switch_cost > 0 || resume_cost > 0)
+    {
+        printf("Context Switch Cost: %d (+%d on cold resume)\n", switch_cost, resume_cost);
+    }
+    if (real_tick_ms > 0)
+    {
+        printf("Real-Process Mode: %d ms clock%s\n", real_tick_ms,
+            nice_baseline ? ", plain nice baseline at shutdown" : "");
+    }
+    if (admission_policy >= 0)
+    {
+        printf("Batch Admission: %s\n", admissionPolicyName(admission_policy));
+    }
+    if (perf != NULL && perf->fds[0] >= 0)
+    {
+        printf("Phase Counters: perf events (%s), %.0f ns per read\n",
+            perf->kernel ? "user and kernel" : "user only", perf->readNanos);
+    }
+    else if (perf != NULL)
+    {
+        printf("Phase Counters: rdtsc (perf events unavailable: %s), %.0f ns per read\n",
+            strerror(perf->unavailable), perf->readNanos);
+    }
+    if (shard_load != NULL)
+    {
+        printf("Dispatcher Shard: serving %s\n", fifo_name);
+    }
+    if (rt_q != NULL)
+    {
+        printf("Real-Time Class: EDF, up to %g%% of the CPU\n", (double)rt_q->maxDensity * 100.0 / RT_PPM);
+    }
+    if (fair_share != NULL)
+    {
+        int i;
+        printf("Fair Share Groups:");
+        for (i = 0; i < fair_share->count; i++)
+        {
+            ShareGroup *G = fair_share->groups[i];
+            printf(" %d (weight %d", G->groupId, G->weight);
+            if (G->memoryQuota > 0)
+            {
+                printf(", quota %lld pages", G->memoryQuota / serverPageSize);
+            }
+            printf(")");
+        }
+        printf("\n");
+    }
     printf("----------------------------------\n");
 
     // Make Fifo cpu_fifo
-    if((mkfifo("cpu_fifo",0666)<0) && errno != EEXIST)
+    // Real-process mode runs what is sent, so only this user may send it
+    if((mkfifo(fifo_name, real_tick_ms > 0 ? REAL_PROCESS_FIFO_MODE : 0666)<0) && errno != EEXIST)
     {
         perror("Unable to create FIFO. Server will terminate.\n");
         exit(1);
     }
 
     // Open FIFO cpu_fifo in Read-Only Mode, Non-Blocking
-    if((fd_in = open("cpu_fifo", O_RDONLY | O_NONBLOCK))<0)
+    if((fd_in = open(fifo_name, O_RDONLY | O_NONBLOCK | O_CLOEXEC))<0)
     {
         perror("Unable to open FIFO. Server will terminate.\n");
-        unlink("cpu_fifo\n");
+        unlink(fifo_name);
         exit(1);
     }    
+    if (real_tick_ms > 0 && restrictFifo(fd_in, fifo_name) < 0)
+    {
+        close(fd_in);
+        exit(1);
+    }
+
+    // Tell the dispatcher this shard is serving
+    if (load_channel != NULL && openShardLoad(load_channel) < 0)
+    {
+        close(fd_in);
+        unlink(fifo_name);
+        exit(1);
+    }
+
+    // Open the completion log for appending
+    if (log_path != NULL && (completion_log = openCompletionLog(log_path)) == NULL)
+    {
+        close(fd_in);
+        unlink(fifo_name);
+        exit(1);
+    }
 
-    // START OF MAIN SCHEDULING LOOP. RUNS FOR "total_clocks" seconds.
-    for (cpu_clock = 0; cpu_clock <total_clocks; cpu_clock++)
+    // Real processes run between clocks, so clocks must be evenly spaced
+    if (real_tick_ms > 0 && (tick_fd = openTickTimer(real_tick_ms)) < 0)
     {
-        // Print current value of cpu_clock
-        printf("\n|-------- CPU Time: %d --------|\n", cpu_clock);
+        close(fd_in);
+        unlink(fifo_name);
+        exit(1);
+    }
 
+    // START OF MAIN SCHEDULING LOOP. RUNS FOR "total_clocks" seconds, or until Ctrl-C.
+    int stop_clock = cpu_clock + total_clocks;
+    for ( ; cpu_clock < stop_clock && !shutdown_requested; cpu_clock++)
+    {
         // Sleep for 2 seconds (to allow pcb_clients to connect and write)
-        sleep(1);
+        if (tick_fd >= 0)
+        {
+            tick_overruns += waitForTick(tick_fd) - 1;
+        }
+        else
+        {
+            sleep(1);
+        }
 
-        // Increase total wait time variable
-        time_waiting_in_ready += rdy_q->size;
+        runClockCycle();
 
-        // Check fifo for new pcbs. If one exists, allocate memory and add to ready queue.
-        PCB *temp_pcb;
-        temp_pcb = receiveNewPCB(fd_in);
-        temp_pcb = allocatePCBMemory(temp_pcb, mem_q); // Sends rejection to sender upon fail
-        addPCBToQueue(rdy_q, temp_pcb);
-        temp_pcb = NULL;
-        
-        // Do work on the PCB currently in "working" state.
-        running_pcb = processCurrentPCB(rdy_q, running_pcb, mem_q);
-        // If no pcbs in the working state, move one in from ready.
-        running_pcb = updateCurrentPCBfromReadyQueue(rdy_q, running_pcb);                
-    
+        // Grow the completion log now, while nothing waits on it
+        prepareCompletionLog(completion_log);
     }   // End of Service For Loop
 
     // Shutdown on completion.
@@ -214,202 +769,1619 @@ int main(int argc, char** argv)
     return 0;
 }
 
-
-/* Allocates memory for a new PCB, and fills it from the cpu_fifo. If fifo read is
-*  successful, returns a pointer. Otherwise, free's allocated memory and returns NULL.
+/* Performs one clock cycle of scheduling: takes in new PCBs, does work on the
+*  PCB in the "running" state and dispatches the next one if needed. New PCBs
+*  come from cpu_fifo, or from the workload in sweep mode.
 */
-PCB* receiveNewPCB(int fd_cpu_in)
+void runClockCycle()
 {
-    // Allocate temp_pcb
-    PCB *this_pcb = (PCB*)malloc(sizeof(PCB));
-    
-    /* Tries to read from fd_in. If empty, continue. If bytesRead = sizeof(PCB) then
-    *  continue. If read is partially completed, loop until finished, then continue.
-    */
-    int bytesRead = 0;
-    do {
-        bytesRead = read(fd_cpu_in, this_pcb, sizeof(PCB));
-    } while (bytesRead >0 && bytesRead<sizeof(PCB));
-    if (bytesRead == sizeof(PCB)) // If PCB is read
+    perfSwitch(perf, PHASE_OTHER);
+
+    // Print current value of cpu_clock
+    printf("\n|-------- CPU Time: %d --------|\n", cpu_clock);
+
+    // PCBs whose I/O burst has completed become ready
+    wakeBlockedPCBs();
+
+    // Retune the round robin quantum from the observed bursts
+    if (adaptive_quantum && cpu_clock % retune_interval == 0)
     {
-        printf("Received: PCB #%d.\n", this_pcb->pcbnumber);
-        return this_pcb;
+        retuneQuantum();
     }
-    else    // If NO PCB is read
+
+    // Check fifo for new pcbs. If one exists, allocate memory and add to ready queue.
+    PCB *temp_pcb;
+    perfSwitch(perf, PHASE_INGEST);
+    if (admission_policy >= 0)
     {
-        free(this_pcb);
-        return NULL;
+        // Batch mode: admit everything that arrived this clock together
+        int arrivals = receiveArrivals();
+        perfSwitch(perf, PHASE_ADMISSION);
+        admitPCBBatch(arrival_batch, arrivals, mem_q, rdy_q);
     }
-}
-
-/* Receives a PCB* and MemQueue*. Returns Null if PCB* is null. Otherwise sets 
-*  PCB start time, allocates a block of memory for the PCB, according to its 
-*  memoryNeeded variable. If memory allocation is unsuccessful it sets the end time 
-*  to -1 and returns the PCB to the sender. If all is successful, returns the PCB.
-*/
-PCB* allocatePCBMemory(PCB* this_pcb, MemQueue* mem)
-{
-    // NULL check for this_pcb
-    if (this_pcb == NULL) 
+    else if (workload != NULL)
     {
-        return this_pcb;
+        while ((temp_pcb = nextWorkloadPCB()) != NULL)
+        {
+            temp_pcb = allocatePCBMemory(temp_pcb, mem_q);
+            addPCBToQueue(rdy_q, temp_pcb);
+            free(temp_pcb);
+        }
     }
-
-    setStart(this_pcb, cpu_clock);
-    int blocksNeeded = (int)ceil((double)this_pcb->memoryNeeded / (double)mem->PageFile_size);
-    if (blocksNeeded > mem->size) // If memory allocation unsuccessful
-    {
-        printf("Insufficient memory to run PCB#%d. Process will be terminated.\n", this_pcb->pcbnumber);
-        int fd_out = open(this_pcb->fifoname, O_WRONLY);
-        this_pcb->endTime = -1;
-        write(fd_out, this_pcb, sizeof(PCB));
-        this_pcb = NULL;
-    }
-    else    // If memory write allocation successful
-    {    
-        this_pcb->pcb_memory_block = requestBlockOfMemory(mem, this_pcb->memoryNeeded);
-        this_pcb->pcb_memory_block->page_size = mem->PageFile_size;
-        printNewlyAllocatedPCB(this_pcb);
+    else
+    {
+        temp_pcb = receiveNewPCB(fd_in);
+        if (temp_pcb != NULL && temp_pcb->requestType != PCB_SUBMIT)
+        {
+            handleClientRequest(temp_pcb);
+            free(temp_pcb);
+            temp_pcb = NULL;
+        }
+        perfSwitch(perf, PHASE_ADMISSION);
+        temp_pcb = allocatePCBMemory(temp_pcb, mem_q); // Sends rejection to sender upon fail
+        addPCBToQueue(rdy_q, temp_pcb);
+        free(temp_pcb);
     }
-    return this_pcb;
+    temp_pcb = NULL;
+    
+    // Do work on the PCB currently in "working" state.
+    perfSwitch(perf, PHASE_EXECUTION);
+    running_pcb = processCurrentPCB(rdy_q, running_pcb, mem_q);
+    // A real-time arrival takes the CPU from anything with a later deadline
+    perfSwitch(perf, PHASE_DISPATCH);
+    preemptForDeadline();
+    // If no pcbs in the working state, move one in from ready.
+    running_pcb = updateCurrentPCBfromReadyQueue(rdy_q, running_pcb);                
+    publishShardLoad();
+    perfEndTick(perf);
 }
 
-// Receives pointers for a pcb_queue and PCB. If the PCB is not null it enqueues it. 
-void addPCBToQueue(pcb_queue* Q, PCB *this_pcb)
+/* Returns a new PCB for the next sweep workload entry arriving by cpu_clock,
+*  or NULL if there is none yet.
+*/
+PCB* nextWorkloadPCB()
 {
-    if (this_pcb != NULL)
+    if (next_arrival == workload->count || workload->arrival[next_arrival] > cpu_clock)
     {
-        enqueue(Q, *this_pcb);
+        return NULL;
     }
+    PCB *this_pcb = (PCB*)calloc(1, sizeof(PCB));
+    this_pcb->pcbnumber = next_arrival + 1;
+    this_pcb->numBursts = workload->num_bursts[next_arrival];
+    memcpy(this_pcb->bursts, workload->bursts[next_arrival], sizeof(this_pcb->bursts));
+    this_pcb->memoryNeeded = workload->memory[next_arrival];
+    next_arrival++;
+    return this_pcb;
 }
 
-/*  Handles operations for the PCB that is in the RUNNING state. If there is one
-*   the round_robin and burst times are decremented. If the process is completed
-*   it is sent back to its originator. If the round_robin time quantum is out the
-*   process is returned to the ready_queue. This process also updates the CPU
-*   statistic variables.
+/* Collects every new PCB arriving this clock into arrival_batch: all of them
+*  waiting in cpu_fifo, or every workload PCB due in sweep mode. Query and
+*  cancel requests are answered as they are read. Returns the number collected.
 */
-PCB* processCurrentPCB(pcb_queue* Q, PCB* in_pcb, MemQueue* mem)
+int receiveArrivals()
 {
-    PCB* this_pcb = in_pcb;
-    if (this_pcb != NULL) {
-        
-        // Increment active_cpu_time
-        ++active_cpu_time;
-
-        // Decrement Remaining Round Robin Time
-        --remaining_rr_time;
-        printf("Remaining RR time: %d\n", remaining_rr_time);
-        
-        // Decrement burst time from currentPCB
-        decrementPCB(this_pcb);
-        printf("Remaining Task Burst: %d\n", this_pcb->remainingBurst);
-
-        // Check if current PCB has finished this clock cycle
-        if(this_pcb->remainingBurst == 0)
+    int count = 0;
+    PCB *this_pcb;
+    for (;;)
+    {
+        this_pcb = (workload != NULL) ? nextWorkloadPCB() : receiveNewPCB(fd_in);
+        if (this_pcb == NULL)
         {
-            // Set CurrentPCB endTime to cpu_clock
-            setEnd(this_pcb, cpu_clock);
-            
-            // Print details of current pcb
-            printCompletedPCB(this_pcb);
-
-            // Return block of memory
-            returnBlockOfMemory(mem,this_pcb->pcb_memory_block);
-
-            // Increase total_turnaround_time by the turnaround time of running_pcb
-            total_turnaround_time += (this_pcb->endTime - this_pcb->startTime);
-
-            // Open FIFO to client in write-only mode
-            int fd_to_client;
-            if((fd_to_client = open(this_pcb->fifoname, O_WRONLY))<0)
-            {
-                printf("Unable to open FIFO to return PCB data.\n");
-            }
-            else
-            {
-                // Write PCB back to client via FIFO
-                write(fd_to_client, this_pcb, sizeof(PCB));
-            }
-                
-            // Increment Completed Tasks
-            completed_tasks++;
-
-            // Set running_pcb to null
+            break;
+        }
+        if (this_pcb->requestType != PCB_SUBMIT)
+        {
+            handleClientRequest(this_pcb);
             free(this_pcb);
-            this_pcb = NULL;
-
-
-            remaining_rr_time = round_robin_max;
-        } 
-        // If Round Robin Time has ended. Push PCB back to queue and clear running_pcb
-        else if (remaining_rr_time == 0)
+            continue;
+        }
+        if (count == arrival_capacity)
         {
-            printf("Returning PCB #%d to Queue\n", this_pcb->pcbnumber);
-            enqueue(Q, *this_pcb);
-            this_pcb = NULL;
+            arrival_capacity = (arrival_capacity > 0) ? arrival_capacity * 2 : 16;
+            arrival_batch = (PCB**)realloc(arrival_batch, arrival_capacity * sizeof(PCB*));
         }
-        
+        arrival_batch[count++] = this_pcb;
     }
-    return this_pcb;
+    return count;
 }
 
-PCB* updateCurrentPCBfromReadyQueue(pcb_queue* Q, PCB* in_pcb)
+/* Advances the blocked set to cpu_clock and moves every PCB whose I/O burst
+*  has completed onto the end of the ready queue.
+*/
+void wakeBlockedPCBs()
 {
-    PCB* this_pcb = in_pcb;
-    // *** Update running_pcb (if empty or completed) from front of Ready Queue ***
-    if (this_pcb == NULL)
+    while (blocked_q->now < cpu_clock)
     {
-        // If queue is not empty
-        if(Q->size >0)
+        WheelNode *N = advanceTimingWheel(blocked_q);
+        while (N != NULL)
         {
-            // Set running_pcb to the first item in the queue and print start 
-            this_pcb = dequeue(Q);
-            remaining_rr_time = round_robin_max;
-            printf("PCB #%d Started\n", this_pcb->pcbnumber);
-            return this_pcb;
+            WheelNode *next = N->next;
+            printf("PCB #%d I/O Complete => Ready Queue\n", N->element.pcbnumber);
+            readyEnqueue(rdy_q, &N->element);
+            free(N);
+            N = next;
         }
-        else
-        {
-            return NULL;
-        }   
+    }
+}
+
+/* Pushes a copy of this_pcb to the end of ready queue Q and records its
+*  pcb_node in the pcb_index. In fair-share mode it goes on its group's
+*  ready queue instead of Q, and a real-time PCB goes on the EDF queue. The
+*  enqueue time is stamped on the PCB so its wait is known when it leaves,
+*  whatever happens to the clock meanwhile.
+*/
+void readyEnqueue(pcb_queue *Q, PCB *this_pcb)
+{
+    this_pcb->readySince = cpu_clock;
+    requeueReady(Q, this_pcb);
+}
+
+// Like readyEnqueue, but keeps the enqueue time already on this_pcb.
+void requeueReady(pcb_queue *Q, PCB *this_pcb)
+{
+    pcb_node *node;
+    if (inRealTimeClass(this_pcb))
+    {
+        // The index holds the heap's own copy of the PCB
+        PCB *copy = edfPush(rt_q, this_pcb);
+        indexPCB(pcb_index, this_pcb->pcbnumber, PCB_READY, copy, rt_q);
+        return;
+    }
+    if (fair_share != NULL)
+    {
+        node = fairEnqueue(fair_share, this_pcb);
+        Q = findShareGroup(fair_share, this_pcb->groupId)->ready;
     }
     else
     {
-        return this_pcb;
+        node = enqueue(Q, *this_pcb);
     }
+    indexPCB(pcb_index, this_pcb->pcbnumber, PCB_READY, node, Q);
 }
 
-/* Prints out final statistics for utilization, average turnaround time, and average
-*  time spent in the waiting queue.
+/* Takes the next PCB to dispatch: the real-time PCB with the earliest
+*  deadline, else the head of ready queue Q, or in fair-share mode the head of
+*  the ready queue of the group with the lowest pass. Returns NULL if nothing
+*  is ready.
 */
-void printFinalServerStatistics()
+PCB* readyDequeue(pcb_queue *Q)
 {
-    // Declare Server Statistics variables
-    double CPU_utilization = 0.0;
-    double averageTurnaround = 0.0;
-    double averageWaitTime = 0.0;
-    // Calculate server statistics
-    if (cpu_clock>0) 
+    if (rt_q != NULL && rt_q->size > 0)
     {
-        CPU_utilization = ((double)active_cpu_time / (double)cpu_clock);
+        return edfPop(rt_q);
     }
-    if (completed_tasks >0)
+    if (fair_share != NULL)
     {
-        averageTurnaround = ((double)total_turnaround_time / (double)completed_tasks);
-        averageWaitTime = ((double)time_waiting_in_ready / (double)completed_tasks);
+        return fairDequeue(fair_share);
     }
-    // Printout server statistics
+    return (Q->size > 0) ? dequeue(Q) : NULL;
+}
+
+/* Charges the clocks this_pcb has just spent in a ready queue to its wait
+*  time. Called when it leaves one. The totals only take it on completion,
+*  since they are averaged over completed PCBs.
+*/
+void recordReadyWait(PCB *this_pcb)
+{
+    this_pcb->waitTime += cpu_clock - this_pcb->readySince;
+}
+
+// Returns the number of ready PCBs, across all groups in fair-share mode and
+// including real-time PCBs.
+int readyCount(pcb_queue *Q)
+{
+    int count = (fair_share != NULL) ? fairReadyCount(fair_share) : Q->size;
+    return (rt_q != NULL) ? count + rt_q->size : count;
+}
+
+/* After a snapshot restore in fair-share mode or with a real-time class,
+*  moves the restored ready PCBs from rdy_q onto their groups' ready queues
+*  or the EDF queue. Charges every held PCB's pages to its group, and
+*  reserves CPU share again for the real-time PCBs whose deadlines are still
+*  ahead (as far as it fits).
+*/
+void regroupReadyPCBs()
+{
+    if (fair_share == NULL && rt_q == NULL)
+    {
+        return;
+    }
+    pcb_node *n;
+    int level, slot, count;
+    WheelNode *w;
+    for (n = rdy_q->head; n != NULL && rt_q != NULL; n = n->next)
+    {
+        if (inRealTimeClass(&n->element))
+        {
+            reserveDensity(rt_q, cpu_clock, n->element.deadlineTime, realTimeDensity(&n->element));
+        }
+    }
+    if (running_pcb != NULL && inRealTimeClass(running_pcb))
+    {
+        reserveDensity(rt_q, cpu_clock, running_pcb->deadlineTime, realTimeDensity(running_pcb));
+    }
+    for (n = rdy_q->head; n != NULL && fair_share != NULL; n = n->next)
+    {
+        findShareGroup(fair_share, n->element.groupId)->pagesHeld += n->element.pcb_memory_block->num_pages;
+    }
+    for (level = 0; level < WHEEL_LEVELS && fair_share != NULL; level++)
+    {
+        for (slot = 0; slot < WHEEL_SLOTS; slot++)
+        {
+            for (w = blocked_q->slots[level][slot]; w != NULL; w = w->next)
+            {
+                findShareGroup(fair_share, w->element.groupId)->pagesHeld += w->element.pcb_memory_block->num_pages;
+            }
+        }
+    }
+    if (running_pcb != NULL && fair_share != NULL)
+    {
+        findShareGroup(fair_share, running_pcb->groupId)->pagesHeld += running_pcb->pcb_memory_block->num_pages;
+    }
+    // Best-effort PCBs without groups go back onto rdy_q itself
+    for (count = rdy_q->size; count > 0; count--)
+    {
+        PCB *this_pcb = dequeue(rdy_q);
+        requeueReady(rdy_q, this_pcb);
+        free(this_pcb);
+    }
+}
+
+/* Moves every ready PCB from the EDF queue and, in fair-share mode, the group
+*  ready queues onto rdy_q, so shutdown can save or return them from one queue.
+*/
+void collectReadyPCBs()
+{
+    PCB *this_pcb;
+    while (rt_q != NULL && (this_pcb = edfPop(rt_q)) != NULL)
+    {
+        enqueue(rdy_q, *this_pcb);
+        free(this_pcb);
+    }
+    while (fair_share != NULL && (this_pcb = fairDequeue(fair_share)) != NULL)
+    {
+        enqueue(rdy_q, *this_pcb);
+        free(this_pcb);
+    }
+}
+
+/* Answers a query or cancel request read from cpu_fifo. The target PCB is
+*  found through the pcb_index in O(1). A cancelled PCB is unlinked from
+*  wherever it is held, its memory is returned and it is sent back to its
+*  sender with endTime END_CANCELLED. The requester gets a copy of the
+*  target PCB with state and numPages filled in, or just its own
+*  request with state PCB_NOT_FOUND.
+*/
+void handleClientRequest(PCB *request)
+{
+    IndexEntry *E = findPCB(pcb_index, request->targetPcb);
+    PCB reply = *request;
+    reply.state = PCB_NOT_FOUND;
+    reply.numPages = 0;
+
+    if (E != NULL)
+    {
+        PCB *target;
+        if (E->state == PCB_READY && E->queue == rt_q)
+        {
+            target = (PCB*)E->where;
+        }
+        else if (E->state == PCB_READY)
+        {
+            target = &((pcb_node*)E->where)->element;
+        }
+        else if (E->state == PCB_BLOCKED)
+        {
+            target = &((WheelNode*)E->where)->element;
+        }
+        else
+        {
+            target = (PCB*)E->where;
+        }
+        reply = *target;
+        reply.state = E->state;
+        reply.numPages = target->pcb_memory_block->num_pages;
+
+        if (request->requestType == PCB_CANCEL)
+        {
+            // Take the PCB out of whatever holds it
+            if (E->state == PCB_READY && E->queue == rt_q)
+            {
+                target = edfRemove(rt_q, target);
+                recordReadyWait(target);
+            }
+            else if (E->state == PCB_READY && fair_share != NULL)
+            {
+                target = fairUnlink(fair_share, (pcb_queue*)E->queue, (pcb_node*)E->where);
+                recordReadyWait(target);
+            }
+            else if (E->state == PCB_READY)
+            {
+                target = unlinkPCBNode((pcb_queue*)E->queue, (pcb_node*)E->where);
+                recordReadyWait(target);
+            }
+            else if (E->state == PCB_BLOCKED)
+            {
+                target = removeTimingWheel(blocked_q, (WheelNode*)E->where);
+            }
+            else
+            {
+                running_pcb = NULL;
+                switch_overhead_remaining = 0;
+                remaining_rr_time = round_robin_max;
+            }
+            unindexPCB(pcb_index, target->pcbnumber);
+            if (fair_share != NULL)
+            {
+                findShareGroup(fair_share, target->groupId)->pagesHeld -= reply.numPages;
+            }
+            killProcess(target);
+            logPCB(target, LOG_CANCELLED);
+
+            returnBlockOfMemory(mem_q, target->pcb_memory_block);
+            setEnd(target, END_CANCELLED);
+            returnPCBToClient(target);
+            free(target);
+            ++cancelled_tasks;
+            reply.state = PCB_CANCELLED;
+            printf("PCB #%d Cancelled: %lld pages released\n", reply.pcbnumber, reply.numPages);
+        }
+        else
+        {
+            printf("PCB #%d Queried: %s\n", reply.pcbnumber, pcbStateName(reply.state));
+        }
+    }
+    else
+    {
+        printf("PCB #%d Not Found for %s\n", request->targetPcb,
+            request->requestType == PCB_CANCEL ? "cancel" : "query");
+    }
+
+    // Reply through the requester's fifo
+    reply.requestType = request->requestType;
+    reply.targetPcb = request->targetPcb;
+    memcpy(reply.fifoname, request->fifoname, sizeof(reply.fifoname));
+    returnPCBToClient(&reply);
+}
+
+/* Indexes every PCB held by the scheduler. Used after restoring a snapshot,
+*  since the index holds pointers which do not survive a restart.
+*/
+void rebuildPCBIndex()
+{
+    pcb_node *n;
+    int level, slot;
+    WheelNode *w;
+    for (n = rdy_q->head; n != NULL; n = n->next)
+    {
+        indexPCB(pcb_index, n->element.pcbnumber, PCB_READY, n, rdy_q);
+    }
+    for (level = 0; level < WHEEL_LEVELS; level++)
+    {
+        for (slot = 0; slot < WHEEL_SLOTS; slot++)
+        {
+            for (w = blocked_q->slots[level][slot]; w != NULL; w = w->next)
+            {
+                indexPCB(pcb_index, w->element.pcbnumber, PCB_BLOCKED, w, blocked_q);
+            }
+        }
+    }
+    if (running_pcb != NULL)
+    {
+        indexPCB(pcb_index, running_pcb->pcbnumber, PCB_RUNNING, running_pcb, NULL);
+    }
+}
+
+/* Runs the sweep workload to completion with the given memory size, page size
+*  and quantum, and returns its statistics. Called in a forked child of
+*  runSweep, so it starts from, and may freely change, its own copy of every
+*  scheduler global. Per-clock output is discarded.
+*/
+SweepResult simulateConfiguration(long long total_memory, long long page_size, int quantum)
+{
+    SweepResult r;
+    memset(&r, 0, sizeof(SweepResult));
+    r.total_memory = total_memory;
+    r.page_size = page_size;
+    r.round_robin = quantum;
+    if (freopen("/dev/null", "w", stdout) == NULL || quantum < 1)
+    {
+        r.failed = 1;
+        return r;
+    }
+
+#ifndef SCHED_STATIC_CONFIG
+    round_robin_max = quantum;
+#endif
+    remaining_rr_time = quantum;
+    rdy_q = new_pcb_queue();
+    blocked_q = new_TimingWheel(0);
+    pcb_index = new_PCBIndex();
+    mem_q = new_MemQueue(total_memory, page_size);
+
+    // Every clock of burst can cost at most one switch, so this bounds the run
+    long long work = 0;
+    int i, j;
+    for (i = 0; i < workload->count; i++)
+    {
+        for (j = 0; j < workload->num_bursts[i]; j++)
+        {
+            work += workload->bursts[i][j];
+        }
+    }
+    long long limit = work * (1 + switch_cost + resume_cost) + 1;
+    if (workload->count > 0)
+    {
+        limit += workload->arrival[workload->count - 1];
+    }
+
+    for (cpu_clock = 0; cpu_clock < limit; cpu_clock++)
+    {
+        int idle = (running_pcb == NULL && readyCount(rdy_q) == 0 && blocked_q->size == 0);
+        if (idle && next_arrival == workload->count)
+        {
+            break;
+        }
+        // Nothing can happen before the next arrival, so jump straight to it.
+        // Waits are taken from enqueue stamps, so skipped clocks cost nothing.
+        if (idle && workload->arrival[next_arrival] > cpu_clock)
+        {
+            cpu_clock = workload->arrival[next_arrival];
+        }
+        runClockCycle();
+    }
+
+    qsort(turnaround_samples.values, turnaround_samples.count, sizeof(int), compareInt);
+    r.clocks = cpu_clock;
+    r.completed = completed_tasks;
+    r.rejected = rejected_tasks;
+    r.context_switches = context_switches;
+    r.utilization = (cpu_clock > 0) ? (double)active_cpu_time / cpu_clock : 0.0;
+    if (completed_tasks > 0)
+    {
+        r.average_turnaround = (double)total_turnaround_time / completed_tasks;
+        r.average_wait = (double)time_waiting_in_ready / completed_tasks;
+    }
+    r.turnaround_p50 = percentileOf(&turnaround_samples, 50);
+    r.turnaround_p90 = percentileOf(&turnaround_samples, 90);
+    r.turnaround_p99 = percentileOf(&turnaround_samples, 99);
+    if (admitted_tasks > 0)
+    {
+        r.average_fragmentation = (double)total_fragmentation / admitted_tasks;
+    }
+    return r;
+}
+
+/* Writes this_pcb back to its sender via pcb->fifoname. PCBs without a
+*  sender (sweep workloads) are skipped.
+*/
+void returnPCBToClient(PCB *this_pcb)
+{
+    if (this_pcb->fifoname[0] == '\0')
+    {
+        return;
+    }
+
+    // Open FIFO to client in write-only mode
+    int fd_to_client;
+    int outer = perfSwitch(perf, PHASE_WRITEBACK);
+    if((fd_to_client = open(this_pcb->fifoname, O_WRONLY))<0)
+    {
+        printf("Unable to writeback PCB#%d\n", this_pcb->pcbnumber);
+    }
+    else
+    {
+        // Write PCB back to client via FIFO
+        write(fd_to_client, this_pcb, sizeof(PCB));
+        close(fd_to_client);
+    }
+    perfSwitch(perf, outer);
+}
+
+
+/* Allocates memory for a new PCB, and fills it from the cpu_fifo. If fifo read is
+*  successful, returns a pointer. Otherwise, free's allocated memory and returns NULL.
+*/
+PCB* receiveNewPCB(int fd_cpu_in)
+{
+    // Allocate temp_pcb
+    PCB *this_pcb = (PCB*)malloc(sizeof(PCB));
+    
+    /* Tries to read from fd_in. If empty, continue. If bytesRead = sizeof(PCB) then
+    *  continue. If read is partially completed, loop until finished, then continue.
+    */
+    int bytesRead = 0;
+    do {
+        bytesRead = read(fd_cpu_in, this_pcb, sizeof(PCB));
+    } while (bytesRead >0 && bytesRead<sizeof(PCB));
+    if (bytesRead == sizeof(PCB)) // If PCB is read
+    {
+        printf("Received: PCB #%d.\n", this_pcb->pcbnumber);
+        // The dispatcher counts what it has sent against what has been read
+        if (this_pcb->requestType == PCB_SUBMIT)
+        {
+            ++shard_values.received;
+            shard_values.receivedPages += submissionPages(this_pcb->memoryNeeded, MEM_PAGE_SIZE(mem_q));
+        }
+        return this_pcb;
+    }
+    else    // If NO PCB is read
+    {
+        free(this_pcb);
+        return NULL;
+    }
+}
+
+/* Receives a PCB* and MemQueue*. Returns Null if PCB* is null. Otherwise sets 
+*  PCB start time, allocates a block of memory for the PCB, according to its 
+*  memoryNeeded variable. If memory allocation is unsuccessful, or would take the
+*  PCB's group over its page quota in fair-share mode, or its deadline cannot be
+*  guaranteed by the real-time class, it sets the end time to -1
+*  and returns the PCB to the sender. A PCB naming a command has it started in a
+*  stopped process limited to the allocated pages. If all is successful, returns
+*  the PCB.
+*/
+PCB* allocatePCBMemory(PCB* this_pcb, MemQueue* mem)
+{
+    // NULL check for this_pcb
+    if (this_pcb == NULL) 
+    {
+        return this_pcb;
+    }
+
+    const char *reason = checkNewPCB(this_pcb);
+    long long blocksNeeded = (reason == NULL) ? pagesRequired(mem, this_pcb->memoryNeeded) : 0;
+    if (reason == NULL && blocksNeeded > mem->size) // If memory allocation unsuccessful
+    {
+        reason = "Insufficient memory";
+    }
+    if (reason == NULL && overGroupQuota(this_pcb, blocksNeeded, mem))
+    {
+        reason = "Group page quota exceeded";
+    }
+    if (reason == NULL && !admitRealTime(this_pcb))
+    {
+        reason = "Deadline cannot be guaranteed";
+    }
+    if (reason != NULL)
+    {
+        rejectPCB(this_pcb, reason);
+        return NULL;
+    }
+
+    // If memory write allocation successful
+    MemBlock *mb = requestBlockOfMemory(mem, this_pcb->memoryNeeded);
+    if (mb == NULL)
+    {
+        rejectPCB(this_pcb, "Unable to allocate memory");
+        return NULL;
+    }
+    reserveGroupPages(this_pcb, blocksNeeded);
+    return admitPCB(this_pcb, mb, mem);
+}
+
+/* Sets the start time of a newly received PCB and checks that it can be run
+*  at all. Returns NULL if so, or the reason it must be rejected.
+*/
+const char* checkNewPCB(PCB *this_pcb)
+{
+    setStart(this_pcb, cpu_clock);
+    this_pcb->command[sizeof(this_pcb->command) - 1] = '\0';
+    this_pcb->childPid = 0;
+    this_pcb->firstDispatchTime = -1;
+    this_pcb->waitTime = 0;
+    if (this_pcb->memoryNeeded < 0 || this_pcb->memoryNeeded > mem_q->total_size)
+    {
+        return "Invalid memory request";
+    }
+    if (!initBursts(this_pcb))  // If burst sequence is invalid
+    {
+        return "Invalid burst sequence";
+    }
+    if (isRealProcess(this_pcb) && real_tick_ms == 0)
+    {
+        return "Real-process mode is off";
+    }
+    if (isRealProcess(this_pcb) && this_pcb->numBursts > 1)
+    {
+        return "I/O bursts cannot be run as a command";
+    }
+    this_pcb->deadlineTime = this_pcb->startTime + this_pcb->deadline;
+    if (this_pcb->deadline < 0)
+    {
+        return "Invalid deadline";
+    }
+    if (isRealTime(this_pcb) && rt_q == NULL)
+    {
+        return "Real-time class is off";
+    }
+    if (isRealTime(this_pcb) && this_pcb->numBursts > 1)
+    {
+        return "I/O bursts cannot have a deadline";
+    }
+    return NULL;
+}
+
+// Returns 1 if this_pcb is scheduled by the real-time class.
+int inRealTimeClass(PCB *this_pcb)
+{
+    return rt_q != NULL && isRealTime(this_pcb);
+}
+
+/* Returns the share of the CPU this_pcb needs to meet its deadline, in parts
+*  per million: its burst plus the worst-case switch overhead it brings (the
+*  switch to it and the switch back to the PCB it preempts), over its deadline.
+*/
+long long realTimeDensity(PCB *this_pcb)
+{
+    long long clocks = this_pcb->totalBurst + 2LL * (switch_cost + resume_cost);
+    return (clocks * RT_PPM + this_pcb->deadline - 1) / this_pcb->deadline;
+}
+
+/* Reserves the CPU share of a real-time PCB until its deadline. Returns 1 if
+*  it fits within the real-time capacity (or this_pcb is best-effort work),
+*  0 if its deadline cannot be guaranteed.
+*/
+int admitRealTime(PCB *this_pcb)
+{
+    if (!inRealTimeClass(this_pcb))
+    {
+        return 1;
+    }
+    return reserveDensity(rt_q, cpu_clock, this_pcb->deadlineTime, realTimeDensity(this_pcb));
+}
+
+// Returns 1 if pages more would take this_pcb's group over its page quota.
+int overGroupQuota(PCB *this_pcb, long long pages, MemQueue *mem)
+{
+#ifdef SCHED_STATIC_CONFIG
+    (void)mem;      // The page shift is a constant
+#endif
+    if (fair_share == NULL)
+    {
+        return 0;
+    }
+    ShareGroup *group = findShareGroup(fair_share, this_pcb->groupId);
+    return group->memoryQuota > 0 && group->pagesHeld + pages > (group->memoryQuota >> MEM_PAGE_SHIFT(mem));
+}
+
+// Charges pages to this_pcb's group in fair-share mode.
+void reserveGroupPages(PCB *this_pcb, long long pages)
+{
+    if (fair_share != NULL)
+    {
+        findShareGroup(fair_share, this_pcb->groupId)->pagesHeld += pages;
+    }
+}
+
+/* Sets the end time of this_pcb to -1, returns it to the sender and frees it,
+*  printing reason.
+*/
+void rejectPCB(PCB *this_pcb, const char *reason)
+{
+    printf("%s for PCB#%d. Process will be terminated.\n", reason, this_pcb->pcbnumber);
+    logPCB(this_pcb, LOG_REJECTED);
+    this_pcb->endTime = END_REJECTED;
+    returnPCBToClient(this_pcb);
+    ++rejected_tasks;
+    if (fair_share != NULL)
+    {
+        ++findShareGroup(fair_share, this_pcb->groupId)->rejected;
+    }
+    if (inRealTimeClass(this_pcb))
+    {
+        ++rt_q->rejected;
+    }
+    free(this_pcb);
+}
+
+/* Gives this_pcb the MemBlock mb, whose pages are already reserved for its
+*  group, starts its command if it names one and updates the admission
+*  statistics. Returns the PCB, or NULL if its command could not be started
+*  (it is then rejected and the memory returned).
+*/
+PCB* admitPCB(PCB *this_pcb, MemBlock *mb, MemQueue *mem)
+{
+    long long blocksNeeded = mb->num_pages;
+    this_pcb->pcb_memory_block = mb;
+    // Start the command stopped, limited to the pages just allocated
+    if (isRealProcess(this_pcb) &&
+        launchProcess(this_pcb, REAL_PROCESS_BASE_AS + blocksNeeded * MEM_PAGE_SIZE(mem)) < 0)
+    {
+        returnBlockOfMemory(mem, mb);
+        reserveGroupPages(this_pcb, -blocksNeeded);
+        rejectPCB(this_pcb, "Unable to start command");
+        return NULL;
+    }
+    if (admission_policy < 0)
+    {
+        printNewlyAllocatedPCB(this_pcb);
+    }
+    else
+    {
+        printf("PCB #%d => Ready Queue (%lld pages)\n", this_pcb->pcbnumber, blocksNeeded);
+    }
+    ++admitted_tasks;
+    if (fair_share != NULL)
+    {
+        ++findShareGroup(fair_share, this_pcb->groupId)->admitted;
+    }
+    if (inRealTimeClass(this_pcb))
+    {
+        ++rt_q->admitted;
+    }
+    total_fragmentation += blocksNeeded * MEM_PAGE_SIZE(mem) - this_pcb->memoryNeeded;
+    // Sample each CPU burst, since the quantum is compared against those
+    int i;
+    for (i = 0; adaptive_quantum && i < this_pcb->numBursts; i += 2)
+    {
+        addQuantileSample(&burst_estimator, this_pcb->bursts[i]);
+    }
+    return this_pcb;
+}
+
+/* Admits a batch of count PCBs which arrived in the same clock. Invalid PCBs
+*  are rejected, the admission policy picks which of the rest fit in the free
+*  pages, all of their memory is carved out in one pass, and they are put on
+*  the ready queue Q in arrival order. The others are rejected. A picked PCB
+*  over its group quota or the real-time capacity is rejected too, and the
+*  policy picks again from the PCBs still waiting with the pages it gave back.
+*  Frees every PCB in batch.
+*/
+void admitPCBBatch(PCB **batch, int count, MemQueue *mem, pcb_queue *Q)
+{
+    if (count == 0)
+    {
+        return;
+    }
+    long long *pages = (long long*)malloc(count * sizeof(long long));
+    long long *waiting_pages = (long long*)malloc(count * sizeof(long long));
+    int *waiting = (int*)malloc(count * sizeof(int));
+    MemBlock **blocks = (MemBlock**)malloc(count * sizeof(MemBlock*));
+    char *admit = (char*)malloc(count);
+    char *decided = (char*)calloc(count, 1);
+    int i, j, valid = 0, admitted = 0;
+
+    // Reject what can never run, keeping the rest in arrival order
+    for (i = 0; i < count; i++)
+    {
+        const char *reason = checkNewPCB(batch[i]);
+        if (reason != NULL)
+        {
+            rejectPCB(batch[i], reason);
+            continue;
+        }
+        pages[valid] = pagesRequired(mem, batch[i]->memoryNeeded);
+        batch[valid++] = batch[i];
+    }
+
+    // Group quotas and real-time capacity are checked in arrival order against
+    // the PCBs admitted before them. Pages a picked PCB fails to use go back to
+    // the PCBs still waiting, so pick again until every pick holds.
+    long long capacity = mem->size;
+    int failed = 1;
+    while (failed > 0)
+    {
+        int num_waiting = 0;
+        for (i = 0; i < valid; i++)
+        {
+            if (!decided[i])
+            {
+                waiting[num_waiting] = i;
+                waiting_pages[num_waiting++] = pages[i];
+            }
+        }
+        if (num_waiting == 0)
+        {
+            break;
+        }
+        selectAdmissions(waiting_pages, num_waiting, capacity, admission_policy, admit);
+        failed = 0;
+        for (j = 0; j < num_waiting; j++)
+        {
+            if (!admit[j])
+            {
+                continue;
+            }
+            i = waiting[j];
+            decided[i] = 1;
+            if (overGroupQuota(batch[i], pages[i], mem))
+            {
+                rejectPCB(batch[i], "Group page quota exceeded");
+            }
+            else if (!admitRealTime(batch[i]))
+            {
+                rejectPCB(batch[i], "Deadline cannot be guaranteed");
+            }
+            else
+            {
+                reserveGroupPages(batch[i], pages[i]);
+                capacity -= pages[i];
+                continue;
+            }
+            batch[i] = NULL;
+            pages[i] = -1;
+            failed++;
+        }
+    }
+    for (i = 0; i < valid; i++)
+    {
+        if (!decided[i])
+        {
+            rejectPCB(batch[i], "Insufficient memory");
+            batch[i] = NULL;
+            pages[i] = -1;
+        }
+    }
+
+    requestBlocksOfMemory(mem, pages, blocks, valid);
+    for (i = 0; i < valid; i++)
+    {
+        if (batch[i] != NULL && blocks[i] == NULL)
+        {
+            reserveGroupPages(batch[i], -pages[i]);
+            rejectPCB(batch[i], "Unable to allocate memory");
+        }
+        else if (blocks[i] != NULL && admitPCB(batch[i], blocks[i], mem) != NULL)
+        {
+            addPCBToQueue(Q, batch[i]);
+            free(batch[i]);
+            admitted++;
+        }
+    }
+    printf("Batch Admission (%s): %d of %d PCBs admitted\n", admissionPolicyName(admission_policy),
+        admitted, count);
+    free(pages);
+    free(waiting_pages);
+    free(waiting);
+    free(blocks);
+    free(admit);
+    free(decided);
+}
+
+// Receives pointers for a pcb_queue and PCB. If the PCB is not null it enqueues it. 
+void addPCBToQueue(pcb_queue* Q, PCB *this_pcb)
+{
+    if (this_pcb != NULL)
+    {
+        readyEnqueue(Q, this_pcb);
+    }
+}
+
+/*  Handles operations for the PCB that is in the RUNNING state. If there is one
+*   the round_robin and burst times are decremented. If the process is completed
+*   it is sent back to its originator. If the round_robin time quantum is out the
+*   process is returned to the ready_queue. This process also updates the CPU
+*   statistic variables.
+*/
+PCB* processCurrentPCB(pcb_queue* Q, PCB* in_pcb, MemQueue* mem)
+{
+    PCB* this_pcb = in_pcb;
+    if (this_pcb != NULL) {
+
+        // Spend this clock switching to the PCB instead of running it
+        if (switch_overhead_remaining > 0)
+        {
+            --switch_overhead_remaining;
+            ++overhead_cycles;
+            printf("Context Switch Overhead: %d remaining\n", switch_overhead_remaining);
+            if (switch_overhead_remaining == 0 && isRealProcess(this_pcb))
+            {
+                resumeProcess(this_pcb);
+                ++signals_sent;
+            }
+            return this_pcb;
+        }
+        last_run_pcb = this_pcb->pcbnumber;
+
+        // A real process has just had a clock on the CPU; see whether it finished
+        if (isRealProcess(this_pcb))
+        {
+            ++granted_ticks;
+            if (reapProcess(this_pcb, WNOHANG))
+            {
+                this_pcb->remainingBurst = 1;   // Completes below
+                ++real_completed;
+                if (nice_baseline)
+                {
+                    recordRealRun(this_pcb);
+                }
+            }
+            else if (this_pcb->remainingBurst == 1)
+            {
+                printf("PCB #%d Exceeded CPU Limit: Killed\n", this_pcb->pcbnumber);
+                killProcess(this_pcb);
+                ++real_killed;
+            }
+        }
+        
+        // Increment active_cpu_time
+        ++active_cpu_time;
+
+        // Charge the clock to the PCB's group, moving its pass on by its stride
+        if (fair_share != NULL)
+        {
+            chargeShareGroup(fair_share, this_pcb->groupId, 1);
+        }
+
+        // Decrement Remaining Round Robin Time. Real-time PCBs run until they
+        // complete or an earlier deadline preempts them.
+        if (inRealTimeClass(this_pcb))
+        {
+            ++rt_q->cpuTime;
+        }
+        else
+        {
+            --remaining_rr_time;
+            printf("Remaining RR time: %d\n", remaining_rr_time);
+        }
+        
+        // Decrement burst time from currentPCB
+        decrementPCB(this_pcb);
+        printf("Remaining Task Burst: %d\n", this_pcb->remainingBurst);
+
+        // Count the clocks where the CPU does work while other PCBs wait on I/O
+        if (blocked_q->size > 0)
+        {
+            ++io_overlap_cycles;
+        }
+
+        // If the CPU burst is done and I/O follows, block until the I/O completes
+        if (this_pcb->remainingBurst == 0 && hasMoreBursts(this_pcb))
+        {
+            int io_burst = startIOBurst(this_pcb, cpu_clock);
+            printf("PCB #%d Blocked for I/O: %d clocks\n", this_pcb->pcbnumber, io_burst);
+            WheelNode *node = insertTimingWheel(blocked_q, *this_pcb);
+            indexPCB(pcb_index, this_pcb->pcbnumber, PCB_BLOCKED, node, blocked_q);
+            free(this_pcb);
+            this_pcb = NULL;
+            ++io_blocks;
+            ++voluntary_preemptions;
+            remaining_rr_time = round_robin_max;
+        }
+        // Check if current PCB has finished this clock cycle
+        else if(this_pcb->remainingBurst == 0)
+        {
+            // Set CurrentPCB endTime to cpu_clock
+            setEnd(this_pcb, cpu_clock);
+            
+            // Print details of current pcb
+            printCompletedPCB(this_pcb);
+            if (isRealProcess(this_pcb))
+            {
+                printf("Exit Status: %d, CPU Time: %lld us\n", this_pcb->exitStatus, this_pcb->cpuMicros);
+                child_cpu_micros += this_pcb->cpuMicros;
+            }
+
+            // Score a real-time PCB against its deadline
+            if (inRealTimeClass(this_pcb))
+            {
+                int lateness = this_pcb->endTime - this_pcb->deadlineTime;
+                ++rt_q->completed;
+                if (lateness > 0)
+                {
+                    printf("PCB #%d Missed Deadline %d by %d clocks\n", this_pcb->pcbnumber,
+                        this_pcb->deadlineTime, lateness);
+                    ++rt_q->misses;
+                    rt_q->totalLateness += lateness;
+                    if (lateness > rt_q->maxLateness)
+                    {
+                        rt_q->maxLateness = lateness;
+                    }
+                }
+            }
+
+            // Release the pages from the group's quota and record its latency
+            if (fair_share != NULL)
+            {
+                ShareGroup *group = findShareGroup(fair_share, this_pcb->groupId);
+                group->pagesHeld -= this_pcb->pcb_memory_block->num_pages;
+                group->totalTurnaround += this_pcb->endTime - this_pcb->startTime;
+                group->totalWait += this_pcb->waitTime;
+                ++group->completed;
+            }
+
+            logPCB(this_pcb, LOG_COMPLETED);
+
+            // Return block of memory
+            returnBlockOfMemory(mem,this_pcb->pcb_memory_block);
+
+            // Increase total_turnaround_time and time_waiting_in_ready by running_pcb's times
+            total_turnaround_time += (this_pcb->endTime - this_pcb->startTime);
+            time_waiting_in_ready += this_pcb->waitTime;
+
+            if (workload != NULL)
+            {
+                addSample(&turnaround_samples, this_pcb->endTime - this_pcb->startTime);
+            }
+
+            // Write PCB back to client via FIFO
+            returnPCBToClient(this_pcb);
+            unindexPCB(pcb_index, this_pcb->pcbnumber);
+                
+            // Increment Completed Tasks
+            completed_tasks++;
+            ++voluntary_preemptions;
+
+            // Set running_pcb to null
+            free(this_pcb);
+            this_pcb = NULL;
+
+
+            remaining_rr_time = round_robin_max;
+        } 
+        // If Round Robin Time has ended. Push PCB back to queue and clear running_pcb
+        else if (remaining_rr_time == 0 && !inRealTimeClass(this_pcb))
+        {
+            printf("Returning PCB #%d to Queue\n", this_pcb->pcbnumber);
+            if (isRealProcess(this_pcb))
+            {
+                suspendProcess(this_pcb);
+                ++signals_sent;
+            }
+            readyEnqueue(Q, this_pcb);
+            free(this_pcb);
+            this_pcb = NULL;
+            ++involuntary_preemptions;
+        }
+        
+    }
+    return this_pcb;
+}
+
+/* Returns running_pcb to its ready queue if the EDF queue holds a PCB with an
+*  earlier deadline. Best-effort PCBs have no deadline, so any ready real-time
+*  PCB preempts them. The next dispatch then takes the real-time PCB.
+*/
+void preemptForDeadline()
+{
+    PCB *next;
+    if (rt_q == NULL || running_pcb == NULL || (next = edfPeek(rt_q)) == NULL)
+    {
+        return;
+    }
+    if (inRealTimeClass(running_pcb) && !edfBefore(next, running_pcb))
+    {
+        return;
+    }
+    printf("PCB #%d Preempted by PCB #%d (deadline %d)\n", running_pcb->pcbnumber, next->pcbnumber,
+        next->deadlineTime);
+    // A process still waiting out its switch overhead was never resumed
+    if (isRealProcess(running_pcb) && switch_overhead_remaining == 0)
+    {
+        suspendProcess(running_pcb);
+        ++signals_sent;
+    }
+    switch_overhead_remaining = 0;
+    readyEnqueue(rdy_q, running_pcb);
+    free(running_pcb);
+    running_pcb = NULL;
+    ++rt_q->preemptions;
+    ++involuntary_preemptions;
+}
+
+PCB* updateCurrentPCBfromReadyQueue(pcb_queue* Q, PCB* in_pcb)
+{
+    PCB* this_pcb = in_pcb;
+    // *** Update running_pcb (if empty or completed) from front of Ready Queue ***
+    if (this_pcb == NULL)
+    {
+        // If queue is not empty
+        if(readyCount(Q) >0)
+        {
+            // Set running_pcb to the first item in the queue and print start 
+            this_pcb = readyDequeue(Q);
+            indexPCB(pcb_index, this_pcb->pcbnumber, PCB_RUNNING, this_pcb, NULL);
+            remaining_rr_time = round_robin_max;
+            recordReadyWait(this_pcb);
+            if (this_pcb->firstDispatchTime < 0)
+            {
+                this_pcb->firstDispatchTime = cpu_clock;
+                total_response_time += cpu_clock - this_pcb->startTime;
+                ++responded_tasks;
+            }
+            // Re-dispatching the PCB that just ran is not a switch
+            if (this_pcb->pcbnumber != last_run_pcb)
+            {
+                ++context_switches;
+                switch_overhead_remaining = switchCost(this_pcb);
+            }
+            if (isRealProcess(this_pcb) && switch_overhead_remaining == 0)
+            {
+                resumeProcess(this_pcb);
+                ++signals_sent;
+            }
+            printf("PCB #%d Started\n", this_pcb->pcbnumber);
+            return this_pcb;
+        }
+        else
+        {
+            return NULL;
+        }   
+    }
+    else
+    {
+        return this_pcb;
+    }
+}
+
+/* Appends a record for this_pcb, which is leaving the scheduler with the given
+*  outcome, to the completion log if one is open. A rejected PCB holds no pages,
+*  so the pages it asked for are recorded.
+*/
+void logPCB(PCB *this_pcb, int outcome)
+{
+    if (completion_log == NULL)
+    {
+        return;
+    }
+    int outer = perfSwitch(perf, PHASE_WRITEBACK);
+    LogRecord r;
+    memset(&r, 0, sizeof(LogRecord));
+    r.pcbnumber = this_pcb->pcbnumber;
+    r.outcome = outcome;
+    r.arrival = this_pcb->startTime;
+    r.firstDispatch = this_pcb->firstDispatchTime;
+    r.end = cpu_clock;
+    r.burst = this_pcb->totalBurst;
+    r.groupId = this_pcb->groupId;
+    r.wait = this_pcb->waitTime;
+    if (outcome == LOG_REJECTED)
+    {
+        r.pages = pagesRequired(mem_q, this_pcb->memoryNeeded);
+    }
+    else
+    {
+        r.pages = this_pcb->pcb_memory_block->num_pages;
+        r.fragmentation = r.pages * MEM_PAGE_SIZE(mem_q) - this_pcb->memoryNeeded;
+    }
+    appendCompletionLog(completion_log, &r);
+    perfSwitch(perf, outer);
+}
+
+/* Returns the clocks needed to switch the CPU to this_pcb: switch_cost, plus
+*  resume_cost when it has run before and another PCB has run since, so its
+*  cache and TLB state is gone.
+*/
+int switchCost(PCB *this_pcb)
+{
+    int cost = switch_cost;
+    if (hasRun(this_pcb) && this_pcb->pcbnumber != last_run_pcb)
+    {
+        cost += resume_cost;
+    }
+    return cost;
+}
+
+/* Copies the CPU statistic and scheduling variables into a snapshot header.
+*  The queue and memory fields are filled in by saveSnapshot.
+*/
+void fillSnapshotHeader(SnapshotHeader *h)
+{
+    h->cpu_clock = cpu_clock;
+    h->active_cpu_time = active_cpu_time;
+    h->time_waiting_in_ready = time_waiting_in_ready;
+    h->total_response_time = total_response_time;
+    h->responded_tasks = responded_tasks;
+    h->total_turnaround_time = total_turnaround_time;
+    h->completed_tasks = completed_tasks;
+    h->cancelled_tasks = cancelled_tasks;
+    h->io_blocks = io_blocks;
+    h->io_overlap_cycles = io_overlap_cycles;
+    h->admitted_tasks = admitted_tasks;
+    h->rejected_tasks = rejected_tasks;
+    h->total_fragmentation = total_fragmentation;
+    h->round_robin_max = round_robin_max;
+    h->remaining_rr_time = remaining_rr_time;
+    h->context_switches = context_switches;
+    h->voluntary_preemptions = voluntary_preemptions;
+    h->involuntary_preemptions = involuntary_preemptions;
+    h->switch_overhead_remaining = switch_overhead_remaining;
+    h->overhead_cycles = overhead_cycles;
+    h->last_run_pcb = last_run_pcb;
+    h->quantum_changes = quantum_changes;
+    h->burst_estimator = burst_estimator;
+}
+
+// Restores the CPU statistic and scheduling variables from a snapshot header.
+void applySnapshotHeader(SnapshotHeader *h)
+{
+    cpu_clock = h->cpu_clock;
+    active_cpu_time = h->active_cpu_time;
+    time_waiting_in_ready = h->time_waiting_in_ready;
+    total_response_time = h->total_response_time;
+    responded_tasks = h->responded_tasks;
+    total_turnaround_time = h->total_turnaround_time;
+    completed_tasks = h->completed_tasks;
+    cancelled_tasks = h->cancelled_tasks;
+    io_blocks = h->io_blocks;
+    io_overlap_cycles = h->io_overlap_cycles;
+    admitted_tasks = h->admitted_tasks;
+    rejected_tasks = h->rejected_tasks;
+    total_fragmentation = h->total_fragmentation;
+#ifndef SCHED_STATIC_CONFIG
+    round_robin_max = h->round_robin_max;
+#endif
+    remaining_rr_time = h->remaining_rr_time;
+    context_switches = h->context_switches;
+    voluntary_preemptions = h->voluntary_preemptions;
+    involuntary_preemptions = h->involuntary_preemptions;
+    switch_overhead_remaining = h->switch_overhead_remaining;
+    overhead_cycles = h->overhead_cycles;
+    last_run_pcb = h->last_run_pcb;
+    quantum_changes = h->quantum_changes;
+    // Keep the saved burst history only if this run asks for the same target
+    if (adaptive_quantum && h->burst_estimator.percentile == burst_estimator.percentile)
+    {
+        burst_estimator = h->burst_estimator;
+    }
+}
+
+/* Sets round_robin_max to the target percentile of the bursts observed so
+*  far, rounded up to a whole clock. PCBs already running keep the quantum
+*  they were dispatched with.
+*/
+void retuneQuantum()
+{
+#ifndef SCHED_STATIC_CONFIG
+    double estimate = getQuantileEstimate(&burst_estimator);
+    if (estimate < 0)
+    {
+        return;
+    }
+    int new_quantum = (int)ceil(estimate);
+    if (new_quantum < 1)
+    {
+        new_quantum = 1;
+    }
+    if (new_quantum != round_robin_max)
+    {
+        printf("Round Robin Quantum: %d -> %d (p%g burst = %.2f)\n", round_robin_max, new_quantum,
+            burst_estimator.percentile * 100.0, estimate);
+        round_robin_max = new_quantum;
+        ++quantum_changes;
+    }
+#endif
+}
+
+/* Signal handler for Ctrl-C. The main loop finishes the current clock cycle
+*  so that the queues are consistent before shutDownProcedures runs.
+*/
+void requestShutdown(int signum)
+{
+    (void)signum;
+    shutdown_requested = 1;
+}
+
+/* Prints out final statistics for utilization, average turnaround time, and average
+*  time spent in the waiting queue.
+*/
+void printFinalServerStatistics()
+{
+    // Declare Server Statistics variables
+    double CPU_utilization = 0.0;
+    double overheadShare = 0.0;
+    double serializedUtilization = 0.0;
+    double averageTurnaround = 0.0;
+    double averageWaitTime = 0.0;
+    // Calculate server statistics
+    if (cpu_clock>0) 
+    {
+        CPU_utilization = ((double)active_cpu_time / (double)cpu_clock);
+        overheadShare = ((double)overhead_cycles / (double)cpu_clock);
+        // Without overlap, every clock of I/O wait hidden behind CPU work adds a clock
+        serializedUtilization = ((double)active_cpu_time / (double)(cpu_clock + io_overlap_cycles));
+    }
+    if (completed_tasks >0)
+    {
+        averageTurnaround = ((double)total_turnaround_time / (double)completed_tasks);
+        averageWaitTime = ((double)time_waiting_in_ready / (double)completed_tasks);
+    }
+    // Printout server statistics
     printf("\n-------------------------\n");
     printf("CPU Scheduling Statistics\n");
     printf("CPU Utilization: %f\n",CPU_utilization);
+    printf("CPU Busy (incl. switch overhead): %f\n", CPU_utilization + overheadShare);
+    printf("Switch Overhead: %d cycles (%f)\n", overhead_cycles, overheadShare);
+    if (io_blocks > 0)
+    {
+        printf("I/O Blocks: %d\n", io_blocks);
+        printf("I/O Overlapped With CPU Work: %d clocks\n", io_overlap_cycles);
+        printf("CPU Utilization Without I/O Overlap: %f (gain %+f)\n", serializedUtilization,
+            CPU_utilization - serializedUtilization);
+    }
     printf("Average Turnaround: %f\n", averageTurnaround);
     printf("Average Wait Time: %f\n", averageWaitTime);
+    if (responded_tasks > 0)
+    {
+        printf("Average Response Time: %f\n", (double)total_response_time / responded_tasks);
+    }
+    printf("Rejected Tasks: %d\n", rejected_tasks);
+    printf("Cancelled Tasks: %d\n", cancelled_tasks);
+    if (admitted_tasks > 0)
+    {
+        printf("Average Fragmentation: %f bytes\n", (double)total_fragmentation / admitted_tasks);
+    }
+    printf("Context Switches: %d\n", context_switches);
+    printf("Voluntary Preemptions: %d\n", voluntary_preemptions);
+    printf("Involuntary Preemptions: %d\n", involuntary_preemptions);
+    printf("Round Robin Quantum: %d", round_robin_max);
+    if (adaptive_quantum)
+    {
+        printf(" (adaptive, %d changes)", quantum_changes);
+    }
+    printf("\n");
+    if (real_tick_ms > 0)
+    {
+        printRealProcessStatistics();
+    }
+    if (rt_q != NULL)
+    {
+        printRealTimeStatistics();
+    }
+    if (perf != NULL)
+    {
+        printPhaseStatistics();
+    }
+    if (fair_share != NULL)
+    {
+        printShareGroupStatistics();
+    }
     printf("-------------------------\n");
 }
 
+/* Remembers the command of real-process PCB this_pcb, which exited this
+*  clock, to be run again for the plain nice baseline.
+*/
+void recordRealRun(PCB *this_pcb)
+{
+    if (real_run_count == real_run_capacity)
+    {
+        real_run_capacity = (real_run_capacity > 0) ? real_run_capacity * 2 : 16;
+        real_runs = (RealRun*)realloc(real_runs, real_run_capacity * sizeof(RealRun));
+    }
+    RealRun *R = &real_runs[real_run_count++];
+    memset(R, 0, sizeof(RealRun));
+    snprintf(R->command, sizeof(R->command), "%s", this_pcb->command);
+    R->addressSpace = REAL_PROCESS_BASE_AS + this_pcb->pcb_memory_block->num_pages * MEM_PAGE_SIZE(mem_q);
+    R->arrivalMicros = (long long)this_pcb->startTime * real_tick_ms * 1000LL;
+    R->cpuMicros = this_pcb->cpuMicros;
+    R->turnaroundMicros = (long long)(cpu_clock - this_pcb->startTime) * real_tick_ms * 1000LL;
+}
+
+/* Prints what real-process mode cost. Under plain nice the kernel hands out
+*  the CPU directly, so every granted clock is spent in the children and the
+*  scheduler costs nothing; here the gap between the slice time granted and
+*  the CPU time the children used (measured with wait4), and the scheduler's
+*  own CPU time from getrusage, are the overhead of slicing from user space.
+*  With -n, the exited commands are then run again under plain nice.
+*/
+void printRealProcessStatistics()
+{
+    struct rusage self;
+    getrusage(RUSAGE_SELF, &self);
+    long long self_micros = (long long)(self.ru_utime.tv_sec + self.ru_stime.tv_sec) * 1000000LL +
+        self.ru_utime.tv_usec + self.ru_stime.tv_usec;
+    long long granted_micros = (long long)granted_ticks * real_tick_ms * 1000LL;
+    printf("Real Processes: %d exited, %d killed at CPU limit\n", real_completed, real_killed);
+    printf("Slice Time Granted: %lld us over %d clocks (%d missed)\n", granted_micros, granted_ticks,
+        tick_overruns);
+    printf("Child CPU Time (wait4): %lld us\n", child_cpu_micros);
+    if (granted_micros > 0)
+    {
+        printf("Slice Efficiency: %f\n", (double)child_cpu_micros / granted_micros);
+    }
+    printf("Scheduler CPU Time: %lld us, %d SIGCONT/SIGSTOP sent\n", self_micros, signals_sent);
+
+    if (!nice_baseline)
+    {
+        return;
+    }
+
+    // Run the exited commands again under plain nice and compare
+    int i, rerun = 0;
+    long long cpu = 0, baseline_cpu = 0, turnaround = 0, baseline_turnaround = 0;
+    printf("Plain Nice Baseline: rerunning %d exited commands under nice %d...\n", real_run_count,
+        REAL_PROCESS_NICE);
+    runNiceBaseline(real_runs, real_run_count);
+    for (i = 0; i < real_run_count; i++)
+    {
+        if (real_runs[i].baselineCpuMicros < 0)
+        {
+            continue;
+        }
+        ++rerun;
+        cpu += real_runs[i].cpuMicros;
+        baseline_cpu += real_runs[i].baselineCpuMicros;
+        turnaround += real_runs[i].turnaroundMicros;
+        baseline_turnaround += real_runs[i].baselineTurnaroundMicros;
+    }
+    if (rerun > 0)
+    {
+        printf("    Child CPU Time: %lld us scheduled, %lld us under nice (%+lld us)\n", cpu, baseline_cpu,
+            cpu - baseline_cpu);
+        printf("    Average Turnaround: %lld us scheduled, %lld us under nice (%+lld us)\n", turnaround / rerun,
+            baseline_turnaround / rerun, (turnaround - baseline_turnaround) / rerun);
+        printf("    Scheduler Overhead: %lld us of its own CPU time, %f us per exited command\n", self_micros,
+            (double)self_micros / rerun);
+    }
+    free(real_runs);
+    real_runs = NULL;
+    real_run_count = 0;
+}
+
+/* Prints how the real-time class did: deadline misses, and the CPU share it
+*  reserved and used, which leaves the rest (the headroom) to best-effort work.
+*/
+void printRealTimeStatistics()
+{
+    advanceReservations(rt_q, cpu_clock);
+    double average = 0.0, used = 0.0;
+    double peak = (double)rt_q->peakReserved / RT_PPM;
+    if (cpu_clock > 0)
+    {
+        average = (double)rt_q->reservedArea / RT_PPM / cpu_clock;
+        used = (double)rt_q->cpuTime / cpu_clock;
+    }
+    printf("Real-Time PCBs: %d admitted, %d rejected, %d completed\n", rt_q->admitted, rt_q->rejected,
+        rt_q->completed);
+    printf("Deadline Misses: %d", rt_q->misses);
+    if (rt_q->misses > 0)
+    {
+        printf(" (average lateness %f, max %d clocks)", (double)rt_q->totalLateness / rt_q->misses,
+            rt_q->maxLateness);
+    }
+    printf("\n");
+    printf("Real-Time Preemptions: %d\n", rt_q->preemptions);
+    printf("Real-Time CPU Time: %d clocks (%f of the CPU)\n", rt_q->cpuTime, used);
+    printf("Reserved Utilization: %f average, %f peak (capacity %f)\n", average, peak,
+        (double)rt_q->maxDensity / RT_PPM);
+    printf("Best-Effort Headroom: %f average, %f minimum\n", 1.0 - average, 1.0 - peak);
+}
+
+/* Maps the load channel named by "load_file:slot" and publishes this shard's
+*  first load to its slot. Returns 0, or -1 if it cannot be used.
+*/
+int openShardLoad(const char *channel)
+{
+    char path[256];
+    int slot, shards;
+    const char *colon = strrchr(channel, ':');
+    if (colon == NULL || colon == channel || (size_t)(colon - channel) >= sizeof(path) ||
+        sscanf(colon + 1, "%d", &slot) != 1)
+    {
+        printf("Load channel must be given as load_file:slot.\n");
+        return -1;
+    }
+    memcpy(path, channel, colon - channel);
+    path[colon - channel] = '\0';
+    ShardLoad *slots = mapLoadChannel(path, &shards, 0);
+    if (slots == NULL)
+    {
+        return -1;
+    }
+    if (slot < 0 || slot >= shards)
+    {
+        printf("Load channel %s has no slot %d.\n", path, slot);
+        return -1;
+    }
+    shard_load = &slots[slot];
+    shard_values = *shard_load;
+    shard_values.pageSize = MEM_PAGE_SIZE(mem_q);
+    publishShardLoad();
+    return 0;
+}
+
+// Publishes this shard's current load to its slot, if it is a shard.
+void publishShardLoad()
+{
+    if (shard_load == NULL)
+    {
+        return;
+    }
+    shard_values.pid = getpid();
+    shard_values.clock = cpu_clock;
+    shard_values.ready = readyCount(rdy_q);
+    shard_values.blocked = blocked_q->size;
+    shard_values.running = (running_pcb != NULL);
+    shard_values.freePages = mem_q->size;
+    shard_values.completed = completed_tasks;
+    storeShardLoad(shard_load, &shard_values);
+}
+
+/* Prints what each phase of the clock cycle cost in total, with IPC and
+*  misses per thousand instructions when hardware counters were available,
+*  and the distribution over clock cycles of the cycles (or rdtsc ticks) each
+*  phase took.
+*/
+void printPhaseStatistics()
+{
+    int i, hardware = (perf->fds[0] >= 0);
+    unsigned long long all = 0;
+    for (i = 0; i < NUM_PHASES; i++)
+    {
+        all += perf->totals[i][0];
+    }
+    printf("Phase Counters (%s, %d clocks, %lld reads at %.0f ns):\n",
+        hardware ? (perf->kernel ? "perf events, user and kernel" : "perf events, user only") : "rdtsc ticks",
+        perf->numTicks, perf->switches, perf->readNanos);
+    if (hardware && perf->running < perf->enabled)
+    {
+        printf("    Counters multiplexed: running %f of the time\n", (double)perf->running / perf->enabled);
+    }
+    printf("    %-10s %14s %6s", "phase", hardware ? counter_names[0] : "ticks", "share");
+    if (hardware)
+    {
+        printf(" %14s %6s %14s %8s %14s %8s", counter_names[1], "IPC", counter_names[2], "MPKI",
+            counter_names[3], "MPKI");
+    }
+    printf("\n");
+    for (i = 0; i < NUM_PHASES; i++)
+    {
+        unsigned long long *c = perf->totals[i];
+        printf("    %-10s %14llu %6.3f", phase_names[i], c[0], all > 0 ? (double)c[0] / all : 0.0);
+        if (hardware)
+        {
+            double kilo = c[1] / 1000.0;
+            printf(" %14llu %6.2f %14llu %8.3f %14llu %8.3f", c[1], c[0] > 0 ? (double)c[1] / c[0] : 0.0,
+                c[2], kilo > 0 ? c[2] / kilo : 0.0, c[3], kilo > 0 ? c[3] / kilo : 0.0);
+        }
+        printf("\n");
+    }
+
+    // Per-clock distributions of counter 0
+    printf("    Per clock (%s):\n", hardware ? counter_names[0] : "ticks");
+    printf("    %-10s %14s %14s %14s %14s %14s\n", "phase", "mean", "p50", "p90", "p99", "max");
+    for (i = 0; i < NUM_PHASES && perf->numTicks > 0; i++)
+    {
+        unsigned long long *s = perf->samples[i];
+        qsort(s, perf->numTicks, sizeof(unsigned long long), compareCounts);
+        printf("    %-10s %14.0f %14llu %14llu %14llu %14llu\n", phase_names[i],
+            (double)perf->totals[i][0] / perf->numTicks, countPercentile(s, perf->numTicks, 50),
+            countPercentile(s, perf->numTicks, 90), countPercentile(s, perf->numTicks, 99),
+            s[perf->numTicks - 1]);
+    }
+}
+
+/* Prints each group's weight, share of the CPU time used, utilization and
+*  latency in fair-share mode.
+*/
+void printShareGroupStatistics()
+{
+    int i, total_weight = 0;
+    for (i = 0; i < fair_share->count; i++)
+    {
+        total_weight += fair_share->groups[i]->weight;
+    }
+    for (i = 0; i < fair_share->count; i++)
+    {
+        ShareGroup *G = fair_share->groups[i];
+        double share = 0.0, utilization = 0.0, turnaround = 0.0, wait = 0.0;
+        if (active_cpu_time > 0)
+        {
+            share = (double)G->cpuTime / (double)active_cpu_time;
+        }
+        if (cpu_clock > 0)
+        {
+            utilization = (double)G->cpuTime / (double)cpu_clock;
+        }
+        if (G->completed > 0)
+        {
+            turnaround = (double)G->totalTurnaround / (double)G->completed;
+            wait = (double)G->totalWait / (double)G->completed;
+        }
+        printf("Group %d: weight %d (target share %f)\n", G->groupId, G->weight,
+            (double)G->weight / (double)total_weight);
+        printf("    CPU Time: %d clocks, Share: %f, Utilization: %f\n", G->cpuTime, share, utilization);
+        printf("    Completed: %d, Average Turnaround: %f, Average Wait Time: %f\n", G->completed,
+            turnaround, wait);
+        printf("    Admitted: %d, Rejected: %d, Pages Held: %lld\n", G->admitted, G->rejected, G->pagesHeld);
+    }
+}
+
 /* Performs all maintenance before program shutdown: 
 *  *  Calls for server statistics to be printed
+*  *  Saves a snapshot, or returns all queued PCBs to their senders
 *  *  Closes and unlinks all fifos
 *  *  Deallocates all variables from memory
 */
@@ -418,31 +2390,69 @@ void shutDownProcedures() {
     // ***** AFTER SERVICE LOOP *****
     printFinalServerStatistics();
 
-    // Push any running PCB back onto queue before queue is cleared out
+    // Gather the group ready queues back into rdy_q
+    collectReadyPCBs();
+
+    // Save the scheduler state so the next start resumes all in-flight work.
+    // Clients stay blocked on their return fifos until then.
+    if (snapshot_path != NULL)
+    {
+        SnapshotHeader snapshot;
+        fillSnapshotHeader(&snapshot);
+        if (saveSnapshot(snapshot_path, &snapshot, running_pcb, rdy_q, blocked_q, mem_q) == 0)
+        {
+            printf("Saved snapshot %s: %d PCBs ready, %d blocked, %s\n", snapshot_path, rdy_q->size,
+                blocked_q->size, running_pcb != NULL ? "1 running" : "none running");
+            while (rdy_q->size != 0)
+            {
+                free(dequeue(rdy_q));
+            }
+            freeWheelNodes(drainTimingWheel(blocked_q));
+            if (running_pcb != NULL)
+            {
+                free(running_pcb);
+                running_pcb = NULL;
+            }
+        }
+    }
+
+    // Push any running or blocked PCB back onto queue before queue is cleared out
     if (running_pcb != NULL)
     {
         enqueue(rdy_q, *running_pcb);
     }
+    WheelNode *blocked = drainTimingWheel(blocked_q);
+    WheelNode *N;
+    for (N = blocked; N != NULL; N = N->next)
+    {
+        enqueue(rdy_q, N->element);
+    }
+    freeWheelNodes(blocked);
     // Sets the end time for each PCB to 0 and returns them. EndTime 0 is read
     // by the client as an error due to server shutdown.
     while(rdy_q->size != 0)
     {
-        int fd_out;
-        running_pcb = dequeue(rdy_q);
-        if((fd_out = open(running_pcb->fifoname, O_WRONLY))<0)
-        {
-            printf("Unable to writeback PCB#%d\n", running_pcb->pcbnumber);
-        }
-        else
+        if (running_pcb != NULL)
         {
-            write(fd_out, running_pcb, sizeof(PCB));
+            free(running_pcb);
         }
-        
+        running_pcb = dequeue(rdy_q);
+        killProcess(running_pcb);
+        returnPCBToClient(running_pcb);
     }
 
     // Close and unlink inbound fifo
     close(fd_in);
-    unlink("cpu_fifo");
+    unlink(fifo_name);
+    if (shard_load != NULL)
+    {
+        shard_values.pid = 0;
+        storeShardLoad(shard_load, &shard_values);
+    }
+    if (completion_log != NULL)
+    {
+        closeCompletionLog(completion_log);
+    }
 
     // Free all allocated variables
     if (running_pcb != NULL)
@@ -0,0 +1,663 @@
+/**************************    dispatcher.c    ***************************
+*
+* Programmer:       Sean Anderson
+*
+* School:           University of Houston - Clear Lake
+*
+* Course:           CSCI 4354 - Operating Systems
+*
+* Environment:      Unix with GNU C Compiler
+*
+* Files Included:   dispatcher.c, pcb_structs.h, mem_structs.h, pcb_index.h,
+*                   shard_load.h, real_process.h
+*
+* Purpose:          To front several CPU_Scheduler shards on one machine. The
+*                   dispatcher starts N shards, each with its own fifo, memory
+*                   pool and clock, and serves cpu_fifo in their place, so
+*                   PCB_Clients are unchanged. Every submitted PCB is forwarded
+*                   to one shard, chosen by power of two choices: two shards are
+*                   picked at random and the PCB goes to the one with less work
+*                   queued, among those with enough free pages for it. Shards
+*                   publish their load every clock over a memory-mapped load
+*                   channel (shard_load.h); PCBs sent since a shard last
+*                   published are counted by the dispatcher, so a burst of
+*                   submissions does not all land on the shard that looked
+*                   idlest. A shard returns each PCB to its client directly.
+*                   Queries and cancels go to the shard the target PCB was sent to.
+*                   Shard fifos are written without blocking: when a shard's
+*                   fifo is full the PCB goes to another, and when every one is
+*                   full it waits in the dispatcher until one has room.
+*
+* Input:            Number of shards, passed from command line, followed by any
+*                   CPU_Scheduler arguments, which every shard is started with.
+*
+*                   Optional: -S scheduler_path (default ./cpu_scheduler).
+*
+* Output:           Each shard's output goes to shard_#.out. Prints each routed
+*                   PCB, and on shutdown how many PCBs and pages each shard was
+*                   sent and completed.
+*
+* Postconditions:   Must close and unlink cpu_fifo, the shard fifos and the load
+*                   channel.
+*
+* Algorithm:        Create the load channel with one slot per shard
+*                   For each shard
+*                       Fork and exec the CPU_Scheduler with -f shard_#_fifo and
+*                           -D load_channel:#, stdout to shard_#.out
+*                   Wait until every shard has published its first load
+*                   Open every shard fifo for writing, non-blocking
+*                   Make and open cpu_fifo
+*
+*                   ** MAIN LOOP ** until every shard has exited, or Ctrl-C
+*                   Wait up to 100 ms (5 ms if PCBs are waiting) for a PCB on cpu_fifo
+*                   If it is a query or cancel
+*                       Forward it to the shard its target was sent to, or
+*                           reply PCB_NOT_FOUND if there is none
+*                   Otherwise
+*                       Pick two live shards at random
+*                       Estimate each one's free pages and queued PCBs from its
+*                           slot, less the PCBs sent to it but not read yet
+*                       Forward the PCB to the one with fewer queued PCBs among
+*                           those with room for it (if neither has room, to the
+*                           shard with most free pages)
+*                       If its fifo is full, try the other, then any live shard
+*                       Record the shard in the PCBIndex
+*                   If no fifo could take the PCB, keep it waiting
+*                   Retry the waiting PCBs in arrival order
+*                   Reap shards which have exited
+*
+*                   ** FINAL CLEANUP **
+*                   Tell the clients of PCBs still waiting the server shut down
+*                   Send SIGINT to every shard still running and wait for them
+*                   Print routing statistics
+*                   Close and unlink every fifo and the load channel
+*
+***********************************************************************/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <unistd.h>
+#include <signal.h>
+#include <poll.h>
+#include <time.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include "pcb_structs.h"
+#include "pcb_index.h"
+#include "shard_load.h"
+#include "real_process.h"
+
+#define MAX_SHARDS 64
+#define LOAD_CHANNEL "dispatch_load"
+
+// Results of forwardPCB
+#define FORWARD_GONE 0      // The shard has exited
+#define FORWARD_SENT 1
+#define FORWARD_FULL 2      // Its fifo is full; it has not read what it was sent
+
+// Dispatcher state for one shard
+typedef struct shard
+{
+    pid_t pid;              // 0 once it has exited
+    int fd;                 // Write end of its fifo
+    char fifoname[24];
+    ShardLoad *load;        // Its slot in the load channel
+    long long sent;         // Submissions forwarded to it
+    long long sentPages;
+    long long forwarded;    // Queries and cancels forwarded to it
+} Shard;
+
+// Dispatcher Variables
+Shard shards[MAX_SHARDS];
+int num_shards = 0;
+int live_shards = 0;
+PCBIndex *routes;           // pcbnumber -> shard (held in the entry's state)
+unsigned long long rng_state;
+long long routed = 0;
+long long both_full = 0;    // Submissions neither choice had room for
+long long not_found = 0;
+long long deferred = 0;     // PCBs held back because their shards' fifos were full
+PCB *pending = NULL;        // PCBs waiting for room in a shard fifo, in arrival order
+int num_pending = 0;
+int pending_capacity = 0;
+volatile sig_atomic_t shutdown_requested = 0;
+
+// Forward Declared Functions
+int startShard(int, const char *, char **, int);
+int readPCB(int, PCB *);
+void dispatchPCB(PCB *);
+void retryPending();
+int routeSubmission(PCB *);
+int chooseShard(long long, int *);
+int forwardPCB(int, PCB *);
+int routeRequest(PCB *);
+void replyToClient(PCB *);
+void reapShards(int);
+unsigned int randomShard();
+void requestShutdown(int);
+void printDispatcherStatistics();
+
+/* Run using:
+*   ./[filename] shards [cpu_scheduler arguments]
+*   ./[filename] -S scheduler_path shards [cpu_scheduler arguments]
+*
+*   e.g. ./dispatcher 4 -u 80 64K 1K starts 4 shards, each with 64K of memory.
+*/
+int main(int argc, char **argv)
+{
+    int opt, i;
+    const char *scheduler_path = "./cpu_scheduler";
+    while ((opt = getopt(argc, argv, "+S:")) != -1)
+    {
+        if (opt == 'S')
+        {
+            scheduler_path = optarg;
+        }
+        else
+        {
+            printf("Usage: %s [-S scheduler_path] shards [cpu_scheduler arguments]\n", argv[0]);
+            exit(1);
+        }
+    }
+    if (optind == argc || (num_shards = atoi(argv[optind])) < 1 || num_shards > MAX_SHARDS)
+    {
+        printf("Number of shards must be between 1 and %d.\n", MAX_SHARDS);
+        exit(1);
+    }
+
+    // A shard that exits while being written to must not kill the dispatcher
+    signal(SIGPIPE, SIG_IGN);
+    signal(SIGINT, requestShutdown);
+    rng_state = (unsigned long long)time(NULL) * 2654435761ULL ^ (unsigned long long)getpid();
+    routes = new_PCBIndex();
+
+    // Create the load channel and start the shards
+    int slots = num_shards;
+    ShardLoad *loads = mapLoadChannel(LOAD_CHANNEL, &slots, 1);
+    if (loads == NULL)
+    {
+        exit(1);
+    }
+    for (i = 0; i < num_shards; i++)
+    {
+        shards[i].load = &loads[i];
+        shards[i].fd = -1;
+        snprintf(shards[i].fifoname, sizeof(shards[i].fifoname), "shard_%d_fifo", i);
+        if ((shards[i].pid = startShard(i, scheduler_path, argv + optind + 1, argc - optind - 1)) > 0)
+        {
+            live_shards++;
+        }
+    }
+
+    // Every shard publishes its load once its fifo is open
+    for (i = 0; i < num_shards; i++)
+    {
+        ShardLoad load;
+        for (;;)
+        {
+            loadShardLoad(shards[i].load, &load);
+            reapShards(WNOHANG);
+            if (load.pid != 0 || shards[i].pid == 0 || shutdown_requested)
+            {
+                break;
+            }
+            usleep(10000);
+        }
+        // Non-blocking, so a shard which is behind never holds up the others
+        if (shards[i].pid != 0 && (shards[i].fd = open(shards[i].fifoname, O_WRONLY | O_NONBLOCK | O_CLOEXEC)) < 0)
+        {
+            perror("Unable to open shard fifo");
+        }
+    }
+    if (live_shards == 0)
+    {
+        printf("No shard could be started. Dispatcher will terminate.\n");
+        unlink(LOAD_CHANNEL);
+        exit(1);
+    }
+
+    // Shards in real-process mode (-x) run the commands they are sent, so
+    // cpu_fifo must be as restricted as their own fifos (see real_process.h).
+    // Any option word holding an x counts, which errs on the safe side.
+    int real_process = 0;
+    for (i = optind + 1; i < argc; i++)
+    {
+        if (argv[i][0] == '-' && strchr(argv[i], 'x') != NULL)
+        {
+            real_process = 1;
+        }
+    }
+
+    // Serve cpu_fifo in place of a single scheduler. Holding it open for
+    // writing too keeps reads blocking instead of seeing end of file.
+    int fd_in;
+    if ((mkfifo("cpu_fifo", real_process ? REAL_PROCESS_FIFO_MODE : 0666) < 0 && errno != EEXIST) ||
+        (fd_in = open("cpu_fifo", O_RDWR | O_CLOEXEC)) < 0)
+    {
+        perror("Unable to open FIFO. Dispatcher will terminate.\n");
+        shutdown_requested = 1;
+        fd_in = -1;
+    }
+    else if (real_process && restrictFifo(fd_in, "cpu_fifo") < 0)
+    {
+        close(fd_in);
+        shutdown_requested = 1;
+        fd_in = -1;
+    }
+    else
+    {
+        printf("\n----- Starting Dispatcher -----\n");
+        printf("Shards: %d (%s)\n", live_shards, scheduler_path);
+        printf("-------------------------------\n");
+        fflush(stdout);
+    }
+
+    // START OF MAIN ROUTING LOOP. RUNS until every shard has exited, or Ctrl-C.
+    struct pollfd pfd;
+    pfd.fd = fd_in;
+    pfd.events = POLLIN;
+    while (!shutdown_requested && live_shards > 0)
+    {
+        PCB this_pcb;
+        // Come back soon for PCBs waiting on a full shard fifo
+        if (poll(&pfd, 1, num_pending > 0 ? 5 : 100) > 0 && readPCB(fd_in, &this_pcb))
+        {
+            dispatchPCB(&this_pcb);
+        }
+        retryPending();
+        reapShards(WNOHANG);
+    }
+
+    // PCBs still waiting never reached a shard
+    for (i = 0; i < num_pending; i++)
+    {
+        if (pending[i].requestType == PCB_SUBMIT)
+        {
+            setEnd(&pending[i], END_SHUTDOWN);
+        }
+        else
+        {
+            pending[i].state = PCB_NOT_FOUND;
+            pending[i].numPages = 0;
+        }
+        replyToClient(&pending[i]);
+    }
+    free(pending);
+
+    // Stop the shards; each returns its own PCBs to their clients
+    for (i = 0; i < num_shards; i++)
+    {
+        if (shards[i].pid != 0)
+        {
+            kill(shards[i].pid, SIGINT);
+        }
+    }
+    reapShards(0);
+    printDispatcherStatistics();
+
+    for (i = 0; i < num_shards; i++)
+    {
+        if (shards[i].fd >= 0)
+        {
+            close(shards[i].fd);
+        }
+        unlink(shards[i].fifoname);
+    }
+    if (fd_in >= 0)
+    {
+        close(fd_in);
+        unlink("cpu_fifo");
+    }
+    unlink(LOAD_CHANNEL);
+    printf("Dispatcher terminated.\n");
+    return 0;
+}
+
+/* Forks and execs shard number slot: scheduler_path -f shard_#_fifo
+*  -D dispatch_load:# followed by the nargs arguments in args, with its output
+*  in shard_#.out. Returns its pid, or 0 if it could not be started.
+*/
+int startShard(int slot, const char *scheduler_path, char **args, int nargs)
+{
+    char channel[64], output[32];
+    char *shard_argv[nargs + 6];
+    int i;
+    snprintf(channel, sizeof(channel), "%s:%d", LOAD_CHANNEL, slot);
+    snprintf(output, sizeof(output), "shard_%d.out", slot);
+    shard_argv[0] = (char*)scheduler_path;
+    shard_argv[1] = "-f";
+    shard_argv[2] = shards[slot].fifoname;
+    shard_argv[3] = "-D";
+    shard_argv[4] = channel;
+    for (i = 0; i < nargs; i++)
+    {
+        shard_argv[5 + i] = args[i];
+    }
+    shard_argv[5 + nargs] = NULL;
+
+    fflush(stdout);
+    pid_t pid = fork();
+    if (pid == 0)
+    {
+        int fd = open(output, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd >= 0)
+        {
+            dup2(fd, STDOUT_FILENO);
+            dup2(fd, STDERR_FILENO);
+            close(fd);
+        }
+        execv(scheduler_path, shard_argv);
+        perror("Unable to start shard");
+        _exit(127);
+    }
+    if (pid < 0)
+    {
+        perror("Unable to fork shard");
+        return 0;
+    }
+    return pid;
+}
+
+/* Reads one PCB from fd into this_pcb, finishing a partial read. Returns 1 if
+*  a whole PCB was read, else 0.
+*/
+int readPCB(int fd, PCB *this_pcb)
+{
+    size_t done = 0;
+    while (done < sizeof(PCB))
+    {
+        ssize_t bytesRead = read(fd, (char*)this_pcb + done, sizeof(PCB) - done);
+        if (bytesRead <= 0)
+        {
+            return 0;
+        }
+        done += bytesRead;
+    }
+    return 1;
+}
+
+/* Routes a PCB read from cpu_fifo, or holds it back in pending if the fifos
+*  it could go to are full.
+*/
+void dispatchPCB(PCB *this_pcb)
+{
+    int done = (this_pcb->requestType == PCB_SUBMIT) ? routeSubmission(this_pcb) : routeRequest(this_pcb);
+    if (done)
+    {
+        return;
+    }
+    if (num_pending == pending_capacity)
+    {
+        pending_capacity = (pending_capacity > 0) ? pending_capacity * 2 : 64;
+        pending = (PCB*)realloc(pending, pending_capacity * sizeof(PCB));
+    }
+    pending[num_pending++] = *this_pcb;
+    deferred++;
+}
+
+// Routes again every PCB in pending, keeping those which still cannot go.
+void retryPending()
+{
+    int i, kept = 0;
+    for (i = 0; i < num_pending; i++)
+    {
+        PCB *this_pcb = &pending[i];
+        int done = (this_pcb->requestType == PCB_SUBMIT) ? routeSubmission(this_pcb) : routeRequest(this_pcb);
+        if (!done)
+        {
+            pending[kept++] = *this_pcb;
+        }
+    }
+    num_pending = kept;
+}
+
+// Records that this_pcb was sent to shard s.
+void recordRoute(int s, PCB *this_pcb)
+{
+    long long pages = submissionPages(this_pcb->memoryNeeded, shards[s].load->pageSize);
+    shards[s].sent++;
+    shards[s].sentPages += pages;
+    indexPCB(routes, this_pcb->pcbnumber, s, NULL, NULL);
+    routed++;
+    printf("PCB #%d => Shard %d\n", this_pcb->pcbnumber, s);
+}
+
+/* Forwards a submitted PCB to the shard chosen for it and records the route.
+*  If that shard's fifo is full the other choice is tried, then any live
+*  shard; if the shard has exited meanwhile, another is chosen. Returns 1 once
+*  the PCB is sent (or, with no shard left, its client is told the server shut
+*  down), or 0 if every live shard's fifo is full.
+*/
+int routeSubmission(PCB *this_pcb)
+{
+    while (live_shards > 0)
+    {
+        int choice[2], c, s, result = FORWARD_FULL;
+        chooseShard(this_pcb->memoryNeeded, choice);
+        for (c = 0; c < 2 && result == FORWARD_FULL; c++)
+        {
+            if ((result = forwardPCB(choice[c], this_pcb)) == FORWARD_SENT)
+            {
+                recordRoute(choice[c], this_pcb);
+                return 1;
+            }
+        }
+        if (result == FORWARD_GONE)
+        {
+            continue;
+        }
+        // Both choices are behind; any shard which can take it beats waiting
+        for (s = 0; s < num_shards; s++)
+        {
+            if (shards[s].pid != 0 && s != choice[0] && s != choice[1] &&
+                forwardPCB(s, this_pcb) == FORWARD_SENT)
+            {
+                recordRoute(s, this_pcb);
+                return 1;
+            }
+        }
+        return 0;
+    }
+    setEnd(this_pcb, END_SHUTDOWN);
+    replyToClient(this_pcb);
+    return 1;
+}
+
+/* Picks the shards for a PCB needing memoryNeeded bytes by power of two
+*  choices, storing the better one in choice[0] and the other in choice[1]. A
+*  shard's free pages and queued PCBs are taken from its slot, less what has
+*  been sent to it but not read yet. Of two random live shards, the one with
+*  room and fewer queued PCBs wins; if neither has room, the one with more free
+*  pages. Returns choice[0].
+*/
+int chooseShard(long long memoryNeeded, int *choice)
+{
+    int c, first;
+    long long room[2], queued[2];
+    choice[0] = randomShard();
+    do
+    {
+        choice[1] = randomShard();
+    } while (live_shards > 1 && choice[1] == choice[0]);
+    for (c = 0; c < 2; c++)
+    {
+        Shard *S = &shards[choice[c]];
+        ShardLoad load;
+        loadShardLoad(S->load, &load);
+        long long pages = submissionPages(memoryNeeded, load.pageSize);
+        long long unread = S->sent - load.received;
+        room[c] = load.freePages - (S->sentPages - load.receivedPages) - pages;
+        queued[c] = load.ready + load.running + unread;
+    }
+    if ((room[0] >= 0) != (room[1] >= 0))
+    {
+        first = (room[0] >= 0) ? 0 : 1;
+    }
+    else if (room[0] < 0)
+    {
+        both_full++;
+        first = (room[0] >= room[1]) ? 0 : 1;
+    }
+    else
+    {
+        first = (queued[0] <= queued[1]) ? 0 : 1;
+    }
+    if (first == 1)
+    {
+        c = choice[0];
+        choice[0] = choice[1];
+        choice[1] = c;
+    }
+    return choice[0];
+}
+
+/* Writes this_pcb to shard s without blocking. Returns FORWARD_SENT,
+*  FORWARD_FULL if its fifo has no room, or FORWARD_GONE if the shard is gone
+*  (it is then marked exited). A PCB is smaller than PIPE_BUF, so it is
+*  written whole or not at all.
+*/
+int forwardPCB(int s, PCB *this_pcb)
+{
+    if (shards[s].fd >= 0)
+    {
+        if (write(shards[s].fd, this_pcb, sizeof(PCB)) == sizeof(PCB))
+        {
+            return FORWARD_SENT;
+        }
+        if (errno == EAGAIN)
+        {
+            return FORWARD_FULL;
+        }
+    }
+    if (shards[s].pid != 0)
+    {
+        shards[s].pid = 0;
+        live_shards--;
+    }
+    return FORWARD_GONE;
+}
+
+// Returns 1 if a submission of PCB pcbnumber is waiting in pending.
+int isPendingSubmission(int pcbnumber)
+{
+    int i;
+    for (i = 0; i < num_pending; i++)
+    {
+        if (pending[i].requestType == PCB_SUBMIT && pending[i].pcbnumber == pcbnumber)
+        {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/* Forwards a query or cancel to the shard its target PCB was sent to, or
+*  replies PCB_NOT_FOUND to the requester if there is none. Returns 1 once
+*  done, or 0 if it must wait: the shard's fifo is full, or the target has
+*  not been sent yet.
+*/
+int routeRequest(PCB *request)
+{
+    IndexEntry *E = findPCB(routes, request->targetPcb);
+    int result = (E != NULL) ? forwardPCB(E->state, request) : FORWARD_GONE;
+    if (result == FORWARD_SENT)
+    {
+        shards[E->state].forwarded++;
+        if (request->requestType == PCB_CANCEL)
+        {
+            unindexPCB(routes, request->targetPcb);
+        }
+        return 1;
+    }
+    if (result == FORWARD_FULL || (E == NULL && isPendingSubmission(request->targetPcb)))
+    {
+        return 0;
+    }
+    not_found++;
+    request->state = PCB_NOT_FOUND;
+    request->numPages = 0;
+    replyToClient(request);
+    return 1;
+}
+
+// Writes this_pcb back to its sender via its fifoname.
+void replyToClient(PCB *this_pcb)
+{
+    int fd_to_client = open(this_pcb->fifoname, O_WRONLY);
+    if (fd_to_client < 0)
+    {
+        printf("Unable to writeback PCB#%d\n", this_pcb->pcbnumber);
+        return;
+    }
+    write(fd_to_client, this_pcb, sizeof(PCB));
+    close(fd_to_client);
+}
+
+/* Reaps shards which have exited, waiting for all of them unless options
+*  includes WNOHANG.
+*/
+void reapShards(int options)
+{
+    pid_t pid;
+    int i, status;
+    while (live_shards > 0 && (pid = waitpid(-1, &status, options)) > 0)
+    {
+        for (i = 0; i < num_shards; i++)
+        {
+            if (shards[i].pid == pid)
+            {
+                shards[i].pid = 0;
+                live_shards--;
+            }
+        }
+    }
+}
+
+// Returns a random live shard (xorshift64).
+unsigned int randomShard()
+{
+    unsigned int s;
+    do
+    {
+        rng_state ^= rng_state << 13;
+        rng_state ^= rng_state >> 7;
+        rng_state ^= rng_state << 17;
+        s = (unsigned int)(rng_state % num_shards);
+    } while (shards[s].pid == 0);
+    return s;
+}
+
+/* Signal handler for Ctrl-C. The routing loop stops and the shards are shut
+*  down in turn.
+*/
+void requestShutdown(int signum)
+{
+    (void)signum;
+    shutdown_requested = 1;
+}
+
+// Prints what each shard was sent and completed.
+void printDispatcherStatistics()
+{
+    int i;
+    long long completed = 0;
+    printf("\n-------------------------\n");
+    printf("Dispatcher Statistics\n");
+    printf("PCBs Routed: %lld (%lld with no shard free for them)\n", routed, both_full);
+    printf("Requests Not Found: %lld\n", not_found);
+    printf("Deferred For Full Shard Fifos: %lld\n", deferred);
+    for (i = 0; i < num_shards; i++)
+    {
+        ShardLoad load;
+        loadShardLoad(shards[i].load, &load);
+        completed += load.completed;
+        printf("Shard %d: sent %lld PCBs (%lld pages), %lld requests; completed %lld by clock %d\n", i,
+            shards[i].sent, shards[i].sentPages, shards[i].forwarded, load.completed, load.clock);
+    }
+    printf("Completed: %lld\n", completed);
+    printf("-------------------------\n");
+}
@@ -0,0 +1,300 @@
+/**************************    fair_share.h    ***************************
+*
+* Programmer:       Sean Anderson
+*
+* School:           University of Houston - Clear Lake
+*
+* Course:           CSCI 4354 - Operating Systems
+*
+* Environment:      Unix with GNU C Compiler
+*
+* Files Included:   cpu_scheduler.c, pcb_structs.h, fair_share.h
+*
+* Purpose:          Header file which contains the ShareGroup and FairShare types
+*                   used for weighted fair-share scheduling between client groups.
+*                   Each group has its own ready queue and is scheduled by stride
+*                   scheduling: every clock a group's PCB runs, the group's pass
+*                   advances by its stride (STRIDE_ONE / weight), and the next PCB
+*                   is always taken from the group with the lowest pass. Groups
+*                   with ready PCBs are kept in a binary min-heap on pass, so a pick
+*                   or a charge is O(log groups). Groups are found by groupId
+*                   through a hash table, and the number of ready PCBs is kept
+*                   as a running count, so neither depends on the group count.
+*
+***********************************************************************/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "pcb_structs.h"
+
+#ifndef FAIR_SHARE_H
+#define FAIR_SHARE_H
+
+#define STRIDE_ONE (1 << 20)
+
+typedef struct share_group ShareGroup;
+typedef struct fair_share FairShare;
+
+struct share_group
+{
+    int groupId;
+    int weight;
+    long long memoryQuota;  // Bytes of pages the group may hold, 0 for no quota
+    long long pagesHeld;
+    long long stride;
+    long long pass;
+    pcb_queue *ready;
+    int heapIndex;          // -1 while not in the heap
+
+    // Per-group statistics
+    int cpuTime;
+    int admitted;
+    int rejected;
+    int completed;
+    long long totalTurnaround;
+    long long totalWait;
+};
+
+struct fair_share
+{
+    ShareGroup **groups;    // In the order they were added
+    int count;
+    int capacity;
+    ShareGroup **table;     // Groups by groupId, open addressing
+    int tableSize;          // Power of 2, at least twice count
+    int ready;              // PCBs ready across all groups
+    ShareGroup **heap;      // Groups with ready PCBs, min-heap on pass
+    int heapSize;
+    long long globalPass;   // Pass of the most recently picked group
+};
+
+/** Null constructor for a new FairShare with no groups. */
+FairShare* new_FairShare()
+{
+    FairShare *F = (FairShare*)calloc(1, sizeof(FairShare));
+    F->capacity = 8;
+    F->groups = (ShareGroup**)malloc(F->capacity * sizeof(ShareGroup*));
+    F->heap = (ShareGroup**)malloc(F->capacity * sizeof(ShareGroup*));
+    F->tableSize = 2 * F->capacity;
+    F->table = (ShareGroup**)calloc(F->tableSize, sizeof(ShareGroup*));
+    return F;
+}
+
+// Returns the table slot holding groupId, or the empty slot it would take
+int shareGroupSlot(FairShare *F, int groupId)
+{
+    unsigned int mask = F->tableSize - 1;
+    unsigned int i = ((unsigned int)groupId * 2654435761u) & mask;
+    while (F->table[i] != NULL && F->table[i]->groupId != groupId)
+    {
+        i = (i + 1) & mask;
+    }
+    return i;
+}
+
+/** Adds a group, or updates it if groupId already exists. Returns it. */
+ShareGroup* addShareGroup(FairShare *F, int groupId, int weight, long long memoryQuota)
+{
+    int i, slot = shareGroupSlot(F, groupId);
+    if (F->table[slot] != NULL)
+    {
+        F->table[slot]->weight = weight;
+        F->table[slot]->stride = STRIDE_ONE / weight;
+        F->table[slot]->memoryQuota = memoryQuota;
+        return F->table[slot];
+    }
+    if (2 * (F->count + 1) > F->tableSize)
+    {
+        // Rehash into a table twice the size
+        free(F->table);
+        F->tableSize *= 2;
+        F->table = (ShareGroup**)calloc(F->tableSize, sizeof(ShareGroup*));
+        for (i = 0; i < F->count; i++)
+        {
+            F->table[shareGroupSlot(F, F->groups[i]->groupId)] = F->groups[i];
+        }
+        slot = shareGroupSlot(F, groupId);
+    }
+    if (F->count == F->capacity)
+    {
+        F->capacity *= 2;
+        F->groups = (ShareGroup**)realloc(F->groups, F->capacity * sizeof(ShareGroup*));
+        F->heap = (ShareGroup**)realloc(F->heap, F->capacity * sizeof(ShareGroup*));
+    }
+    ShareGroup *G = (ShareGroup*)calloc(1, sizeof(ShareGroup));
+    G->groupId = groupId;
+    G->weight = weight;
+    G->stride = STRIDE_ONE / weight;
+    G->memoryQuota = memoryQuota;
+    G->pass = F->globalPass;
+    G->ready = new_pcb_queue();
+    G->heapIndex = -1;
+    F->groups[F->count++] = G;
+    F->table[slot] = G;
+    return G;
+}
+
+/** Returns the group for groupId, adding it with weight 1 and no page
+ *  quota if it has not been configured. */
+ShareGroup* findShareGroup(FairShare *F, int groupId)
+{
+    ShareGroup *G = F->table[shareGroupSlot(F, groupId)];
+    if (G != NULL)
+    {
+        return G;
+    }
+    return addShareGroup(F, groupId, 1, 0);
+}
+
+/* Parses a group list such as "1:3,2:1:256K" (group:weight[:memory_quota])
+*  into F. Quotas accept size suffixes and are enforced in whole pages.
+*  Returns 0, or -1 if an entry is invalid.
+*/
+int parseShareGroups(FairShare *F, const char *text)
+{
+    char buffer[1024], *token, *save;
+    snprintf(buffer, sizeof(buffer), "%s", text);
+    for (token = strtok_r(buffer, ",", &save); token != NULL; token = strtok_r(NULL, ",", &save))
+    {
+        int groupId, weight, used = 0;
+        long long quota = 0;
+        if (sscanf(token, "%d:%d%n", &groupId, &weight, &used) != 2 || weight < 1 || weight > STRIDE_ONE)
+        {
+            return -1;
+        }
+        if (token[used] == ':')
+        {
+            if ((quota = parseMemorySize(token + used + 1)) < 1)
+            {
+                return -1;
+            }
+        }
+        else if (token[used] != '\0')
+        {
+            return -1;
+        }
+        addShareGroup(F, groupId, weight, quota);
+    }
+    return 0;
+}
+
+// Swaps heap positions i and j
+void swapShareGroups(FairShare *F, int i, int j)
+{
+    ShareGroup *temp = F->heap[i];
+    F->heap[i] = F->heap[j];
+    F->heap[j] = temp;
+    F->heap[i]->heapIndex = i;
+    F->heap[j]->heapIndex = j;
+}
+
+// Restores the heap order around position i after its pass changed
+void siftShareGroup(FairShare *F, int i)
+{
+    while (i > 0 && F->heap[(i - 1) / 2]->pass > F->heap[i]->pass)
+    {
+        swapShareGroups(F, i, (i - 1) / 2);
+        i = (i - 1) / 2;
+    }
+    for (;;)
+    {
+        int smallest = i, left = 2 * i + 1, right = 2 * i + 2;
+        if (left < F->heapSize && F->heap[left]->pass < F->heap[smallest]->pass) smallest = left;
+        if (right < F->heapSize && F->heap[right]->pass < F->heap[smallest]->pass) smallest = right;
+        if (smallest == i)
+        {
+            break;
+        }
+        swapShareGroups(F, i, smallest);
+        i = smallest;
+    }
+}
+
+// Removes the group at the top of the heap
+void popShareGroup(FairShare *F)
+{
+    F->heap[0]->heapIndex = -1;
+    F->heapSize--;
+    if (F->heapSize > 0)
+    {
+        F->heap[0] = F->heap[F->heapSize];
+        F->heap[0]->heapIndex = 0;
+        siftShareGroup(F, 0);
+    }
+}
+
+/** Pushes a copy of PCB p onto its group's ready queue and returns the new
+ *  pcb_node. A group that had nothing ready rejoins the heap with its pass
+ *  moved up to the current global pass, so idle time does not bank credit. */
+pcb_node* fairEnqueue(FairShare *F, PCB *p)
+{
+    ShareGroup *G = findShareGroup(F, p->groupId);
+    pcb_node *node = enqueue(G->ready, *p);
+    F->ready++;
+    if (G->heapIndex < 0)
+    {
+        if (G->pass < F->globalPass)
+        {
+            G->pass = F->globalPass;
+        }
+        G->heapIndex = F->heapSize;
+        F->heap[F->heapSize++] = G;
+        siftShareGroup(F, G->heapIndex);
+    }
+    return node;
+}
+
+/** Pops the first PCB of the group with the lowest pass, or returns NULL if
+ *  nothing is ready. Groups whose queues were emptied by a cancel are
+ *  dropped from the heap here. */
+PCB* fairDequeue(FairShare *F)
+{
+    while (F->heapSize > 0)
+    {
+        ShareGroup *G = F->heap[0];
+        if (G->ready->size == 0)
+        {
+            popShareGroup(F);
+            continue;
+        }
+        F->globalPass = G->pass;
+        PCB *p = dequeue(G->ready);
+        F->ready--;
+        if (G->ready->size == 0)
+        {
+            popShareGroup(F);
+        }
+        return p;
+    }
+    return NULL;
+}
+
+/** Unlinks pcb_node node from group ready queue Q, as for a cancel, and
+ *  returns a copy of its PCB. An emptied group leaves the heap on the next
+ *  fairDequeue. */
+PCB* fairUnlink(FairShare *F, pcb_queue *Q, pcb_node *node)
+{
+    F->ready--;
+    return unlinkPCBNode(Q, node);
+}
+
+/** Charges groupId for clocks of CPU time, advancing its pass. */
+void chargeShareGroup(FairShare *F, int groupId, int clocks)
+{
+    ShareGroup *G = findShareGroup(F, groupId);
+    G->pass += G->stride * clocks;
+    G->cpuTime += clocks;
+    if (G->heapIndex >= 0)
+    {
+        siftShareGroup(F, G->heapIndex);
+    }
+}
+
+/** Returns the number of PCBs ready across all groups. */
+int fairReadyCount(FairShare *F)
+{
+    return F->ready;
+}
+
+#endif
@@ -0,0 +1,134 @@
+/**************************    log_reader.c    ***************************
+*
+* Programmer:       Sean Anderson
+*
+* School:           University of Houston - Clear Lake
+*
+* Course:           CSCI 4354 - Operating Systems
+*
+* Environment:      Unix with GNU C Compiler
+*
+* Files Included:   log_reader.c, completion_log.h
+*
+* Purpose:          To summarize a completion log written by the CPU_Scheduler
+*                   (-l log_file). The log is memory mapped read-only and scanned
+*                   once, front to back, with every aggregate kept in registers,
+*                   so the scan runs at the speed memory can be streamed.
+*
+* Input:            Path of the completion log, passed from command line.
+*
+* Output:           Prints record counts by outcome, turnaround, response and wait
+*                   time of completed PCBs, memory pages and fragmentation, and
+*                   how fast the scan ran.
+*
+* Algorithm:        Open and map the log read-only, advise sequential access
+*                   Check the header and that the file holds count records
+*                   For each record
+*                       Count it by outcome
+*                       If completed, add its turnaround, response and ready-queue wait
+*                       Add its pages and fragmentation
+*                   Print the aggregates and the scan rate
+*
+***********************************************************************/
+
+#define _GNU_SOURCE // mremap, used by completion_log.h
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "completion_log.h"
+
+/* Run using:
+*   ./[filename] log_file
+*/
+int main(int argc, char **argv)
+{
+    if (argc != 2)
+    {
+        printf("Usage: %s log_file\n", argv[0]);
+        exit(1);
+    }
+
+    int fd = open(argv[1], O_RDONLY);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) < 0 || st.st_size < (off_t)sizeof(LogHeader))
+    {
+        printf("Unable to read completion log %s\n", argv[1]);
+        exit(1);
+    }
+    const char *base = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED)
+    {
+        perror("Unable to map completion log");
+        exit(1);
+    }
+    madvise((void*)base, st.st_size, MADV_SEQUENTIAL);
+
+    const LogHeader *h = (const LogHeader*)base;
+    if (h->magic != LOG_MAGIC || h->version != LOG_VERSION || h->record_size != (int)sizeof(LogRecord) ||
+        !logCountFits(h->count, st.st_size))
+    {
+        printf("%s is not a completion log.\n", argv[1]);
+        exit(1);
+    }
+    const LogRecord *records = (const LogRecord*)(base + sizeof(LogHeader));
+    long long count = h->count, i;
+
+    struct timespec start, stop;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    // One pass; completed-only sums are masked instead of branched on
+    long long outcomes[3] = { 0, 0, 0 };
+    long long turnaround = 0, response = 0, wait = 0, burst = 0, pages = 0, fragmentation = 0;
+    int max_turnaround = 0;
+    for (i = 0; i < count; i++)
+    {
+        const LogRecord *r = &records[i];
+        long long done = (r->outcome == LOG_COMPLETED);
+        int t = r->end - r->arrival;
+        outcomes[(r->outcome >= 0 && r->outcome < 3) ? r->outcome : LOG_REJECTED]++;
+        turnaround += done * t;
+        response += done * (r->firstDispatch - r->arrival);
+        wait += done * r->wait;
+        burst += done * r->burst;
+        pages += r->pages;
+        fragmentation += r->fragmentation;
+        if (done && t > max_turnaround)
+        {
+            max_turnaround = t;
+        }
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &stop);
+    double seconds = (stop.tv_sec - start.tv_sec) + (stop.tv_nsec - start.tv_nsec) / 1e9;
+    long long completed = outcomes[LOG_COMPLETED];
+
+    printf("\n-------------------------\n");
+    printf("Completion Log: %s\n", argv[1]);
+    printf("Records: %lld\n", count);
+    printf("Completed: %lld\n", completed);
+    printf("Rejected: %lld\n", outcomes[LOG_REJECTED]);
+    printf("Cancelled: %lld\n", outcomes[LOG_CANCELLED]);
+    if (completed > 0)
+    {
+        printf("Average Turnaround: %f\n", (double)turnaround / completed);
+        printf("Maximum Turnaround: %d\n", max_turnaround);
+        printf("Average Response: %f\n", (double)response / completed);
+        printf("Average Wait: %f\n", (double)wait / completed);
+        printf("Average Burst: %f\n", (double)burst / completed);
+    }
+    if (count > 0)
+    {
+        printf("Average Pages: %f\n", (double)pages / count);
+        printf("Average Fragmentation: %f bytes\n", (double)fragmentation / count);
+    }
+    if (seconds > 0)
+    {
+        printf("Scan: %.3f s, %.1f M records/s, %.2f GB/s\n", seconds, count / seconds / 1e6,
+            count * sizeof(LogRecord) / seconds / 1e9);
+    }
+    printf("-------------------------\n");
+
+    munmap((void*)base, st.st_size);
+    return 0;
+}
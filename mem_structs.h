@@ -12,7 +12,8 @@
 *
 * Environment:      Unix with GNU C Compiler
 *
-* Files Included:   cpu_scheduler.c, pcb_client.c, pcb_structs.h, mem_structs.h
+* Files Included:   cpu_scheduler.c, pcb_client.c, pcb_structs.h, mem_structs.h,
+*                   static_config.h
 *
 * Purpose:          Header file which contains data types for PageFile, MemNode,
 *                   MemBlock, and MemQueue and methods associated with each.
@@ -21,6 +22,9 @@
 
 #include <stdlib.h>
 #include <stdio.h>
+#include <ctype.h>
+#include <stdint.h>
+#include "static_config.h"
 
 #ifndef MEM_STRUCTS
 #define MEM_STRUCTS
@@ -30,12 +34,15 @@ typedef struct m_node MemNode;
 typedef struct block MemBlock;
 typedef struct m_queue MemQueue;
 PageFile dequeuePageFile(MemQueue*);
-void enqueueNode(MemQueue *, int);
-int roundUpPower2(int);
+void enqueueNode(MemQueue *, long long);
+long long roundUpPower2(long long);
+
+// Largest power of 2 a long long holds; larger sizes cannot be rounded up
+#define MAX_MEMORY_SIZE (1LL << 62)
 
 struct page 
 {
-    int memory_start_address;
+    long long memory_start_address;
 }; 
 
 struct m_node
@@ -46,37 +53,80 @@ struct m_node
 
 struct block
 {
-    int num_pages;
-    int page_size;
-    PageFile** memory_block;
+    long long num_pages;
+    long long page_size;
+    PageFile* memory_block;     // num_pages PageFiles, allocated with the MemBlock
 };
 
+/* Free pages are held in two places: MemNodes for pages which have been
+*  returned, and the untouched region [next_unused_address, total_size)
+*  which has never been handed out. size counts the pages in both.
+*  PageFile_size is a power of 2, so page counts use page_shift and page_mask.
+*/
 struct m_queue
 {
     MemNode *first;
     MemNode *last;
-    int PageFile_size;
-    int size;
+    long long PageFile_size;
+    int page_shift;
+    long long page_mask;
+    long long size;
+    long long total_size;
+    long long next_unused_address;
 };
 
-MemNode* new_MemNode(int start_address)
+#ifdef SCHED_STATIC_CONFIG
+/* A returned page is never on the free list twice, so one node per page is
+*  enough. Nodes are taken from this pool and recycled instead of malloc'd.
+*/
+MemNode mem_node_pool[SCHED_TOTAL_PAGES];
+MemNode *free_mem_nodes = NULL;
+long long mem_nodes_used = 0;
+#endif
+
+MemNode* new_MemNode(long long start_address)
 {
-    MemNode *N = (MemNode *)malloc(sizeof(MemNode));
-    PageFile *S = (PageFile *)malloc(sizeof(PageFile));
-    S->memory_start_address = start_address;
-    N->memory = *S;
+    MemNode *N;
+#ifdef SCHED_STATIC_CONFIG
+    if (free_mem_nodes != NULL)
+    {
+        N = free_mem_nodes;
+        free_mem_nodes = N->next;
+    }
+    else if (mem_nodes_used < SCHED_TOTAL_PAGES)
+    {
+        N = &mem_node_pool[mem_nodes_used++];
+    }
+    else
+#endif
+    N = (MemNode *)malloc(sizeof(MemNode));
+    N->memory.memory_start_address = start_address;
     return N;
 }
 
+// Releases a MemNode made by new_MemNode
+void freeMemNode(MemNode *N)
+{
+#ifdef SCHED_STATIC_CONFIG
+    if (N >= mem_node_pool && N < mem_node_pool + SCHED_TOTAL_PAGES)
+    {
+        N->next = free_mem_nodes;
+        free_mem_nodes = N;
+        return;
+    }
+#endif
+    free(N);
+}
+
 
-/* Create a new MemQueue* Q with PageFile sized MemNodes which
-*  account for all memory
+/* Create a new MemQueue* Q which accounts for all memory. No MemNodes are
+*  created up front; pages are carved from the untouched region on demand,
+*  so startup cost does not depend on the memory size.
 */
-MemQueue* new_MemQueue(int total_size, int page_size)
+MemQueue* new_MemQueue(long long total_size, long long page_size)
 {
     MemQueue *Q;
-    int memory_address = 0; // Memory address for first MemNode
-    if ( total_size <2 || page_size < 1 || total_size < page_size)
+    if ( total_size <2 || page_size < 1 || total_size < page_size || total_size > MAX_MEMORY_SIZE)
     {
         printf("Invalid values for Memory Size and Page File.\n");
         exit(1);
@@ -86,20 +136,29 @@ MemQueue* new_MemQueue(int total_size, int page_size)
         total_size = roundUpPower2(total_size);
         page_size = roundUpPower2(page_size);
     }
+#ifdef SCHED_STATIC_CONFIG
+    if (total_size != SCHED_TOTAL_MEMORY || page_size != SCHED_PAGE_SIZE)
+    {
+        printf("This scheduler was built for %lld bytes of memory in %lld byte pages.\n",
+            SCHED_TOTAL_MEMORY, SCHED_PAGE_SIZE);
+        exit(1);
+    }
+#endif
 
     // Allocate space for new MemQueue and set initial values
     Q = (MemQueue *)malloc(sizeof(MemQueue));
-    Q->size = 0;
+    Q->size = total_size / page_size;
     Q->PageFile_size = page_size;
-    Q->first = NULL;
-    Q->last = NULL;
-
-    // Create MemNodes for remaining available memory space
-    while ((memory_address) < total_size)
+    Q->page_shift = 0;
+    while ((1LL << Q->page_shift) < page_size)
     {
-        enqueueNode(Q, memory_address);
-        memory_address += page_size;
+        Q->page_shift++;
     }
+    Q->page_mask = page_size - 1;
+    Q->total_size = total_size;
+    Q->next_unused_address = 0;
+    Q->first = NULL;
+    Q->last = NULL;
     
     return Q;
 }
@@ -113,7 +172,7 @@ int isEmpty_Mem(MemQueue* Q)
 /* Create a new MemNode N with the parameter address
 *  add the new MemNode N to the end of MemQueue Q  
 */
-void enqueueNode (MemQueue* Q, int address)
+void enqueueNode (MemQueue* Q, long long address)
 {
     MemNode *N = new_MemNode(address);
     N->next = NULL;
@@ -122,47 +181,125 @@ void enqueueNode (MemQueue* Q, int address)
         Q->last->next = N;
     }
     Q->last = N;
-    if(isEmpty_Mem(Q)){
+    if(Q->first == NULL){
         Q->first = N;
     }
     Q->size++;
 }
 
-MemBlock* requestBlockOfMemory(MemQueue* Q, int memory_requested)
+// Returns the number of PageFiles needed to hold memory_requested bytes
+long long pagesRequired(MemQueue* Q, long long memory_requested)
 {
-    MemBlock* mb;
-    mb = (MemBlock *)malloc(sizeof(MemBlock));
-    int blocksRequired = (int)ceil(((double)memory_requested/ (double)Q->PageFile_size));
+#ifdef SCHED_STATIC_CONFIG
+    (void)Q;        // The page geometry is a constant
+#endif
+    return (memory_requested + MEM_PAGE_MASK(Q)) >> MEM_PAGE_SHIFT(Q);
+}
 
-    if(Q->size >= blocksRequired)
+/* Allocates a MemBlock and its num_pages PageFiles with a single malloc.
+*  Returns NULL if num_pages is negative or the malloc fails.
+*/
+MemBlock* new_MemBlock(long long num_pages, long long page_size)
+{
+    if (num_pages < 0 || (unsigned long long)num_pages > (SIZE_MAX - sizeof(MemBlock)) / sizeof(PageFile))
+    {
+        return NULL;
+    }
+    MemBlock *mb = (MemBlock *)malloc(sizeof(MemBlock) + num_pages * sizeof(PageFile));
+    if (mb == NULL)
+    {
+        return NULL;
+    }
+    mb->num_pages = num_pages;
+    mb->page_size = page_size;
+    mb->memory_block = (PageFile *)(mb + 1);
+    return mb;
+}
+
+/* Takes num_pages free pages from MemQueue Q into out: returned pages first,
+*  then consecutive pages from the untouched region. Q must hold enough.
+*/
+void carvePages(MemQueue* Q, PageFile* out, long long num_pages)
+{
+    long long i = 0;
+    while (i < num_pages && Q->first != NULL)
+    {
+        out[i++] = dequeuePageFile(Q);
+    }
+    Q->size -= num_pages - i;
+    for ( ; i < num_pages; i++)
     {
-        mb->memory_block = (PageFile **)malloc(blocksRequired * sizeof(PageFile *));
-        int i;
-        for(i=0;i<blocksRequired;i++)
+        out[i].memory_start_address = Q->next_unused_address;
+        Q->next_unused_address += MEM_PAGE_SIZE(Q);
+    }
+}
+
+MemBlock* requestBlockOfMemory(MemQueue* Q, long long memory_requested)
+{
+    long long blocksRequired = pagesRequired(Q, memory_requested);
+    if(Q->size < blocksRequired)
+    {
+        return new_MemBlock(0, Q->PageFile_size);
+    }
+    MemBlock* mb = new_MemBlock(blocksRequired, Q->PageFile_size);
+    if (mb == NULL)
+    {
+        return NULL;
+    }
+    carvePages(Q, mb->memory_block, blocksRequired);
+    return mb;
+}
+
+/* Carves blocks for many requests in one pass over the free pages. For each
+*  i, blocks[i] gets a MemBlock of pages[i] pages, or NULL if pages[i] < 0
+*  or its malloc fails. The total must fit in Q. Returns the number of pages
+*  handed out.
+*/
+long long requestBlocksOfMemory(MemQueue* Q, const long long* pages, MemBlock** blocks, int count)
+{
+    long long total = 0;
+    int i;
+    for (i = 0; i < count; i++)
+    {
+        if (pages[i] < 0)
+        {
+            blocks[i] = NULL;
+            continue;
+        }
+        if ((blocks[i] = new_MemBlock(pages[i], Q->PageFile_size)) == NULL)
         {
-            mb->memory_block[i] = (PageFile *)malloc(sizeof(PageFile));
-            *mb->memory_block[i] = dequeuePageFile(Q);
+            continue;
         }
-        mb->num_pages = blocksRequired;
+        carvePages(Q, blocks[i]->memory_block, pages[i]);
+        total += pages[i];
     }
-    return mb;
+    return total;
 }
 
 
 
-/* Returns the first MemNode in MemQueue Q. */
+/* Returns the first MemNode in MemQueue Q. If no returned pages are queued,
+*  the next page is carved from the untouched region instead.
+*/
 PageFile dequeuePageFile(MemQueue* Q)
 {
     MemNode *N = Q->first;
+    PageFile ms;
+    if(N == NULL)
+    {
+        ms.memory_start_address = Q->next_unused_address;
+        Q->next_unused_address += MEM_PAGE_SIZE(Q);
+        Q->size--;
+        return ms;
+    }
     if(Q->first == Q->last)
     {
         Q->last=NULL;
     }
     Q->first = N->next;
     Q->size--;
-    PageFile ms;
     ms = N->memory;
-    free(N);
+    freeMemNode(N);
     return ms;
 }
 
@@ -175,23 +312,23 @@ PageFile removeNode (MemNode* removedNode, MemNode* previousNode)
 
 void returnBlockOfMemory(MemQueue* Q, MemBlock* mb)
 {
-    int i;
+    long long i;
     for(i=0;i<mb->num_pages;i++)
     {
-        enqueueNode(Q, mb->memory_block[i]->memory_start_address);
+        enqueueNode(Q, mb->memory_block[i].memory_start_address);
     }
     free(mb);
 }
 
 // Round up number to the nearest power of 2. Return -1 on fail.
-int roundUpPower2(int number)
+long long roundUpPower2(long long number)
 {
-    if (number <1)
+    if (number <1 || number > MAX_MEMORY_SIZE)
     {
         return -1;
     }
 
-    int temp=1;
+    long long temp=1;
     while (temp < number)
     {
         temp <<= 1;
@@ -201,11 +338,42 @@ int roundUpPower2(int number)
 
 void printMemoryBlock(MemBlock *mb)
 {
-    int i;
+    long long i;
     for(i=0;i<mb->num_pages;i++)
     {
-        printf("Block #%d <= Pagefile #%d\n", i, mb->memory_block[i]->memory_start_address);
+        printf("Block #%lld <= Pagefile #%lld\n", i, mb->memory_block[i].memory_start_address);
+    }
+}
+
+/* Parses a memory size such as "4096", "64K", "16M" or "64G" (binary
+*  multiples, case-insensitive, optional trailing 'B'). Returns -1 on fail.
+*/
+long long parseMemorySize(const char *text)
+{
+    char *end;
+    long long value = strtoll(text, &end, 10);
+    if (end == text || value < 0)
+    {
+        return -1;
+    }
+
+    int shift = 0;
+    switch (toupper((unsigned char)*end))
+    {
+        case 'K': shift = 10; end++; break;
+        case 'M': shift = 20; end++; break;
+        case 'G': shift = 30; end++; break;
+        case 'T': shift = 40; end++; break;
+    }
+    if (toupper((unsigned char)*end) == 'B')
+    {
+        end++;
+    }
+    if (*end != '\0' || value > (0x7FFFFFFFFFFFFFFFLL >> shift))
+    {
+        return -1;
     }
+    return value << shift;
 }
 
 
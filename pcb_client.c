@@ -22,10 +22,25 @@
 *                   to this process via a return fifo. Finally, this program will
 *                   print the PCB statistics before closing itself.
 *
-* Input:            PCB burst time and memory requirements, passed from commmand line
+* Input:            PCB burst time and memory requirements, passed from commmand line,
+*                   optionally followed by pairs of I/O burst and CPU burst times
 *
 * Preconditions:    CPU_Scheduler must be running.
 *
+*                   Or, -q pcb_number / -k pcb_number to query the state of, or
+*                   cancel, a PCB already submitted to the CPU_Scheduler.
+*
+*                   Optional: -g group_id. The client group the PCB is charged to
+*                   when the CPU_Scheduler runs in fair-share mode (default 0).
+*
+*                   Optional: -d deadline. Makes the PCB real-time: it must complete
+*                   within deadline clocks of arriving. A CPU_Scheduler with a
+*                   real-time class (-u) rejects it if that cannot be guaranteed.
+*
+*                   Optional: -x command. A shell command for a CPU_Scheduler in
+*                   real-process mode to run; the burst time is then its CPU limit
+*                   in clocks and the memory its address-space allowance.
+*
 * Output:           Prints the details of the PCB when it is completed.
 *
 * Postconditions:   Must close inbound fifo and unlink it.
@@ -38,6 +53,7 @@
 *                   Set this_pcb.totalBurst and this_pcb.remainingBurst to
 *                       input parameter amount
 *                   Set this_pcb.memoryNeeded to input parameter amount
+*                   Set this_pcb.bursts to the CPU and I/O burst sequence
 *                   Create fifo named this_pcb.fifoname
 *                   Open cpu_fifo in write-only mode
 *                   Write this_pcb to fifo
@@ -61,6 +77,7 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <fcntl.h>
 #include <sys/types.h>
 #include <sys/stat.h>
@@ -71,27 +88,123 @@
 /* Run using: 
 *   ./[filename]
 *   ./[filename] pcb_burst_time pcb_memory_needed (positive integers)
+*   ./[filename] pcb_burst_time pcb_memory_needed io_burst_time pcb_burst_time ...
+*   ./[filename] -q pcb_number (query the state of a submitted PCB)
+*   ./[filename] -k pcb_number (cancel a submitted PCB)
+*   ./[filename] -g group_id pcb_burst_time pcb_memory_needed ...
+*   ./[filename] -x "command" pcb_cpu_limit pcb_memory_needed
+*   ./[filename] -d deadline pcb_burst_time pcb_memory_needed
+*
+*   pcb_memory_needed accepts size suffixes, e.g. 512K, 16M or 2G. Each extra
+*   pair adds an I/O burst followed by another CPU burst.
 */
 int main(int argc, char **argv)
 {
+    // Capture a query or cancel request, leaving the PCB arguments from argv[1]
+    int opt, requestType = PCB_SUBMIT, groupId = 0, deadline = 0;
+    pid_t targetPcb = 0;
+    const char *command = "";
+    while ((opt = getopt(argc, argv, "q:k:g:x:d:")) != -1)
+    {
+        switch (opt)
+        {
+            case 'q':
+                requestType = PCB_QUERY;
+                targetPcb = atoi(optarg);
+                break;
+            case 'k':
+                requestType = PCB_CANCEL;
+                targetPcb = atoi(optarg);
+                break;
+            case 'g':
+                groupId = atoi(optarg);
+                break;
+            case 'x':
+                command = optarg;
+                break;
+            case 'd':
+                deadline = atoi(optarg);
+                if (deadline < 1)
+                {
+                    printf("Deadline must be a positive number of clocks.\n");
+                    printf("PCB Request Terminating.\n");
+                    exit(1);
+                }
+                break;
+            default:
+                printf("PCB Request Terminating.\n");
+                exit(1);
+        }
+    }
+    argc -= optind - 1;
+    argv += optind - 1;
+
     // Check for invalid arguments.
-    if (argc != 3)
+    if (requestType != PCB_SUBMIT && (argc != 1 || targetPcb < 1))
+    {
+        printf("A query or cancel takes only the PCB number.\n");
+        printf("PCB Request Terminating.\n");
+        exit(1);
+    }
+    if (requestType == PCB_SUBMIT && (argc < 3 || argc % 2 == 0 || argc - 2 > MAX_BURSTS))
     {
         printf("Command must contain 2 arguments: total burst time and total memory allocation required.\n");
+        printf("They may be followed by up to %d pairs of I/O burst and CPU burst times.\n", (MAX_BURSTS - 1) / 2);
         printf("PCB Request Terminating.\n");
         exit(1);
     }
 
     // Capture burst time from command line (argv)
-    int burst = atoi(argv[1]);
-    int memoryRequired = atoi(argv[2]);
+    int burst = (argc > 1) ? atoi(argv[1]) : 0;
+    long long memoryRequired = (argc > 2) ? parseMemorySize(argv[2]) : 0;
+    if (memoryRequired < 0)
+    {
+        printf("Invalid memory allocation: %s\n", argv[2]);
+        printf("PCB Request Terminating.\n");
+        exit(1);
+    }
     
     
     // Create new PCB struct called this_pcb
-    PCB *this_pcb = (PCB*)malloc(sizeof(PCB));
+    PCB *this_pcb = (PCB*)calloc(1, sizeof(PCB));
     this_pcb->totalBurst = burst;
     this_pcb->remainingBurst = burst;
     this_pcb->memoryNeeded = memoryRequired;
+
+    this_pcb->requestType = requestType;
+    this_pcb->targetPcb = targetPcb;
+    this_pcb->groupId = groupId;
+    this_pcb->deadline = deadline;
+    if (strlen(command) >= sizeof(this_pcb->command))
+    {
+        printf("Command must be shorter than %d characters.\n", (int)sizeof(this_pcb->command));
+        printf("PCB Request Terminating.\n");
+        exit(1);
+    }
+    strcpy(this_pcb->command, command);
+
+    // Capture the CPU and I/O burst sequence, starting with the burst above
+    int i;
+    this_pcb->numBursts = (argc > 2) ? argc - 2 : 0;
+    this_pcb->bursts[0] = burst;
+    for (i = 1; i < this_pcb->numBursts; i++)
+    {
+        this_pcb->bursts[i] = atoi(argv[i + 2]);
+    }
+    for (i = 0; i < this_pcb->numBursts; i++)
+    {
+        if (this_pcb->bursts[i] < 1)
+        {
+            printf("Burst times must be positive integers.\n");
+            printf("PCB Request Terminating.\n");
+            exit(1);
+        }
+        if (i % 2 == 0 && i > 0)
+        {
+            this_pcb->totalBurst += this_pcb->bursts[i];
+        }
+    }
+    this_pcb->remainingBurst = this_pcb->totalBurst;
     
     // Get fifoname string using pid ("FIFO_#pid#")
     this_pcb->pcbnumber = getpid();
@@ -114,9 +227,37 @@ int main(int argc, char **argv)
         exit(1);
     }
     printf("\n-------------------------\n");
-    printf("Sending PCB #%d\n", this_pcb->pcbnumber);
-    printf("Total PCB Burst: %d\n", this_pcb->totalBurst);
-    printf("Requesting %dB memory\n", this_pcb->memoryNeeded);
+    if (requestType != PCB_SUBMIT)
+    {
+        printf("Sending %s for PCB #%d\n", (requestType == PCB_QUERY) ? "Query" : "Cancel", targetPcb);
+    }
+    else
+    {
+        printf("Sending PCB #%d\n", this_pcb->pcbnumber);
+        printf("Total PCB Burst: %d\n", this_pcb->totalBurst);
+        if (groupId != 0)
+        {
+            printf("Group: %d\n", groupId);
+        }
+        if (command[0] != '\0')
+        {
+            printf("Command: %s\n", command);
+        }
+        if (deadline > 0)
+        {
+            printf("Deadline: %d clocks\n", deadline);
+        }
+        if (this_pcb->numBursts > 1)
+        {
+            printf("CPU/I-O Bursts:");
+            for (i = 0; i < this_pcb->numBursts; i++)
+            {
+                printf(" %s%d", (i % 2 == 0) ? "cpu " : "io ", this_pcb->bursts[i]);
+            }
+            printf("\n");
+        }
+        printf("Requesting %lldB memory\n", this_pcb->memoryNeeded);
+    }
     printf("-------------------------\n");
 
     // Write this_pcb to fifo
@@ -144,17 +285,40 @@ int main(int argc, char **argv)
     }
 
     // print out pcb statistics (see pcb_structs for more detail)
-    if(this_pcb->endTime == -1)
+    if(requestType != PCB_SUBMIT)
+    {
+        printf("PCB #%d: %s\n", targetPcb, pcbStateName(this_pcb->state));
+        if (this_pcb->state == PCB_CANCELLED)
+        {
+            printf("Pages Released: %lld\n", this_pcb->numPages);
+        }
+        else if (this_pcb->state != PCB_NOT_FOUND)
+        {
+            printf("PCB Arrived at time: %d\n", this_pcb->startTime);
+            printf("Remaining Burst: %d of %d\n", this_pcb->remainingBurst, this_pcb->totalBurst);
+            printf("Memory Pages: %lld\n", this_pcb->numPages);
+        }
+    }
+    else if(this_pcb->endTime == END_REJECTED)
+    {
+        printf("Insufficient Memory, Group Quota or Real-Time Capacity: Process terminated.\n");
+    }
+    else if(this_pcb->endTime == END_CANCELLED)
     {
-        printf("Insufficient Memory: Process terminated.\n");
+        printf("Cancelled: Process terminated.\n");
     }
-    else if(this_pcb->endTime == 0)
+    else if(this_pcb->endTime == END_SHUTDOWN)
     {
         printf("Server Shutdown: Process Terminated.\n");
     }
     else
     {
         printCompletedPCB(this_pcb);
+        if (this_pcb->command[0] != '\0')
+        {
+            printf("Exit Status: %d\n", this_pcb->exitStatus);
+            printf("CPU Time Used: %lld us\n", this_pcb->cpuMicros);
+        }
     }
 
     // Close fifo from cpu    
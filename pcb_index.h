@@ -0,0 +1,131 @@
+/**************************    pcb_index.h    ***************************
+*
+* Programmer:       Sean Anderson
+*
+* School:           University of Houston - Clear Lake
+*
+* Course:           CSCI 4354 - Operating Systems
+*
+* Environment:      Unix with GNU C Compiler
+*
+* Files Included:   cpu_scheduler.c, pcb_structs.h, pcb_index.h
+*
+* Purpose:          Header file which contains the PCBIndex, a hash table from
+*                   pcbnumber to where the scheduler currently holds that PCB:
+*                   its pcb_node in a ready queue, the running PCB, or its
+*                   wheel_node in the blocked set. Lookups, updates and removals
+*                   are O(1) on average; the table doubles when it gets full.
+*
+***********************************************************************/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include "pcb_structs.h"
+
+#ifndef PCB_INDEX_H
+#define PCB_INDEX_H
+
+typedef struct index_entry IndexEntry;
+typedef struct pcb_index PCBIndex;
+
+struct index_entry
+{
+    pid_t pcbnumber;
+    int state;      // PCB_READY, PCB_RUNNING or PCB_BLOCKED
+    void *where;    // pcb_node*, PCB* or WheelNode* respectively
+    void *queue;    // The structure holding where, when it has one
+    IndexEntry *next;
+};
+
+struct pcb_index
+{
+    IndexEntry **buckets;
+    int num_buckets;    // Always a power of 2
+    int size;
+};
+
+/** Null constructor for a new, empty PCBIndex. */
+PCBIndex* new_PCBIndex()
+{
+    PCBIndex *I = (PCBIndex*)malloc(sizeof(PCBIndex));
+    I->num_buckets = 64;
+    I->buckets = (IndexEntry**)calloc(I->num_buckets, sizeof(IndexEntry*));
+    I->size = 0;
+    return I;
+}
+
+// Returns the bucket for pcbnumber in a table of num_buckets buckets
+int indexBucket(pid_t pcbnumber, int num_buckets)
+{
+    unsigned int h = (unsigned int)pcbnumber * 2654435761u;
+    return (int)((h ^ (h >> 16)) & (unsigned int)(num_buckets - 1));
+}
+
+/** Returns the IndexEntry for pcbnumber, or NULL if it is not indexed. */
+IndexEntry* findPCB(PCBIndex *I, pid_t pcbnumber)
+{
+    IndexEntry *E = I->buckets[indexBucket(pcbnumber, I->num_buckets)];
+    while (E != NULL && E->pcbnumber != pcbnumber)
+    {
+        E = E->next;
+    }
+    return E;
+}
+
+/** Records that pcbnumber is now in state, held at where inside queue
+ *  (NULL if none). Adds the entry if pcbnumber is not yet indexed. */
+void indexPCB(PCBIndex *I, pid_t pcbnumber, int state, void *where, void *queue)
+{
+    IndexEntry *E = findPCB(I, pcbnumber);
+    if (E == NULL)
+    {
+        // Double the table before it gets crowded
+        if (I->size >= I->num_buckets)
+        {
+            int i, num_buckets = I->num_buckets * 2;
+            IndexEntry **buckets = (IndexEntry**)calloc(num_buckets, sizeof(IndexEntry*));
+            for (i = 0; i < I->num_buckets; i++)
+            {
+                while (I->buckets[i] != NULL)
+                {
+                    IndexEntry *moved = I->buckets[i];
+                    I->buckets[i] = moved->next;
+                    int b = indexBucket(moved->pcbnumber, num_buckets);
+                    moved->next = buckets[b];
+                    buckets[b] = moved;
+                }
+            }
+            free(I->buckets);
+            I->buckets = buckets;
+            I->num_buckets = num_buckets;
+        }
+        int b = indexBucket(pcbnumber, I->num_buckets);
+        E = (IndexEntry*)malloc(sizeof(IndexEntry));
+        E->pcbnumber = pcbnumber;
+        E->next = I->buckets[b];
+        I->buckets[b] = E;
+        I->size++;
+    }
+    E->state = state;
+    E->where = where;
+    E->queue = queue;
+}
+
+/** Removes pcbnumber from the index, if present. */
+void unindexPCB(PCBIndex *I, pid_t pcbnumber)
+{
+    IndexEntry **link = &I->buckets[indexBucket(pcbnumber, I->num_buckets)];
+    while (*link != NULL && (*link)->pcbnumber != pcbnumber)
+    {
+        link = &(*link)->next;
+    }
+    if (*link != NULL)
+    {
+        IndexEntry *E = *link;
+        *link = E->next;
+        free(E);
+        I->size--;
+    }
+}
+
+#endif
@@ -29,6 +29,25 @@
 #ifndef pcb_structs_h
 #define pcb_structs_h
 
+#define MAX_BURSTS 15 // CPU and I/O bursts per PCB, alternating, CPU first and last
+
+// PCB requestType values: what a PCB written to cpu_fifo asks the scheduler for
+#define PCB_SUBMIT 0    // Run this PCB
+#define PCB_QUERY 1     // Report the state of PCB targetPcb
+#define PCB_CANCEL 2    // Cancel PCB targetPcb and release its memory
+
+// PCB state values, reported in replies to queries and cancels
+#define PCB_NOT_FOUND 0
+#define PCB_READY 1
+#define PCB_RUNNING 2
+#define PCB_BLOCKED 3
+#define PCB_CANCELLED 4
+
+// PCB endTime values read by the client as errors
+#define END_SHUTDOWN 0
+#define END_REJECTED -1
+#define END_CANCELLED -2
+
 // PCB struct
 typedef struct pcb
 {
@@ -39,7 +58,25 @@ typedef struct pcb
     int startTime;
     int endTime;
     MemBlock* pcb_memory_block;
-    int memoryNeeded;
+    long long memoryNeeded;
+    int numBursts;
+    int currentBurst;
+    int bursts[MAX_BURSTS];
+    int ioCompleteTime;
+    int requestType;
+    pid_t targetPcb;
+    int state;
+    long long numPages;   // Pages held by targetPcb, in query and cancel replies
+    int groupId;          // Client group, for fair-share scheduling
+    char command[128];    // Shell command to run in real-process mode, or empty
+    pid_t childPid;       // Its process while it is alive
+    int exitStatus;       // Its exit status, or 128 + signal
+    long long cpuMicros;  // CPU time it used, measured with wait4
+    int firstDispatchTime;    // Clock it first ran, or -1
+    int readySince;       // Clock it last entered a ready queue
+    int waitTime;         // Clocks spent in ready queues so far
+    int deadline;         // Clocks after arrival it must complete in, 0 for best effort
+    int deadlineTime;     // Clock it must complete by, set on arrival
 
 } PCB;
 
@@ -55,7 +92,7 @@ void setEnd (PCB *p, int end)
     p->endTime = end;
 }
 
-void setMemoryNeeded(PCB *p, int amount)
+void setMemoryNeeded(PCB *p, long long amount)
 {
     p->memoryNeeded = amount;
 }
@@ -66,11 +103,70 @@ void decrementPCB(PCB *p)
     p->remainingBurst--;
 }
 
+/* Checks the burst sequence of PCB p, dropping a trailing I/O burst and
+*  treating a PCB without one as a single CPU burst of totalBurst. Sets
+*  totalBurst to the total CPU time and remainingBurst to the first CPU
+*  burst. Returns 1 if every burst is positive, else 0.
+*/
+int initBursts(PCB *p)
+{
+    int i;
+    if (p->numBursts < 1 || p->numBursts > MAX_BURSTS)
+    {
+        p->numBursts = 1;
+        p->bursts[0] = p->totalBurst;
+    }
+    if (p->numBursts % 2 == 0)
+    {
+        p->numBursts--;
+    }
+    p->totalBurst = 0;
+    for (i = 0; i < p->numBursts; i++)
+    {
+        if (p->bursts[i] < 1)
+        {
+            return 0;
+        }
+        if (i % 2 == 0)
+        {
+            p->totalBurst += p->bursts[i];
+        }
+    }
+    p->currentBurst = 0;
+    p->remainingBurst = p->bursts[0];
+    return 1;
+}
+
+// Returns 1 if PCB p has been on the CPU before, else 0
+int hasRun(PCB *p)
+{
+    return p->currentBurst > 0 || p->remainingBurst < p->bursts[p->currentBurst];
+}
+
+// Returns 1 if PCB p has another CPU burst after its current one, else 0
+int hasMoreBursts(PCB *p)
+{
+    return p->currentBurst + 2 < p->numBursts;
+}
+
+/* Moves PCB p past its completed CPU burst and the I/O burst that follows it,
+*  which will complete at clock now + I/O burst. Returns the I/O burst.
+*/
+int startIOBurst(PCB *p, int now)
+{
+    int io_burst = p->bursts[p->currentBurst + 1];
+    p->ioCompleteTime = now + io_burst;
+    p->currentBurst += 2;
+    p->remainingBurst = p->bursts[p->currentBurst];
+    return io_burst;
+}
+
 // pcb_node struct
 typedef struct node
 {
     PCB element;
     struct node *next;
+    struct node *prev;
 } pcb_node;
 
 // pcb_queue struct
@@ -101,12 +197,14 @@ int isEmpty(pcb_queue *q)
 }
 
 /** Creates a new pcb_node which stores the value of PCB p. 
- *  Pushes the new pcb_node to the end of pcb_queue q. */
-void enqueue(pcb_queue *q, PCB p)
+ *  Pushes the new pcb_node to the end of pcb_queue q and
+ *  returns it. */
+pcb_node* enqueue(pcb_queue *q, PCB p)
 {
     pcb_node *temp = (pcb_node*)malloc(sizeof(pcb_node));
     temp->element = p;
     temp->next = NULL;
+    temp->prev = q->tail;
 
     if (isEmpty(q))
     {
@@ -119,7 +217,7 @@ void enqueue(pcb_queue *q, PCB p)
     }
     q->tail = temp;
     ++q->size;
-    
+    return temp;
 }
 
 /** Pops the first pcb_node from the pcb_queue q. Creates a PCB
@@ -137,12 +235,60 @@ PCB* dequeue(pcb_queue *q)
     pcb_node *oldhead = q->head;
     *temp = q->head->element;
     q->head = oldhead->next;
+    if (q->head != NULL)
+    {
+        q->head->prev = NULL;
+    }
+    else
+    {
+        q->tail = NULL;
+    }
     free(oldhead);
     --q->size;
     return temp;
     
 }
 
+/** Unlinks pcb_node n from anywhere in pcb_queue q in O(1). Creates
+ *  a PCB with the values from the node and returns a pointer to it. */
+PCB* unlinkPCBNode(pcb_queue *q, pcb_node *n)
+{
+    PCB *temp = (PCB*)malloc(sizeof(PCB));
+    *temp = n->element;
+    if (n->prev != NULL)
+    {
+        n->prev->next = n->next;
+    }
+    else
+    {
+        q->head = n->next;
+    }
+    if (n->next != NULL)
+    {
+        n->next->prev = n->prev;
+    }
+    else
+    {
+        q->tail = n->prev;
+    }
+    free(n);
+    --q->size;
+    return temp;
+}
+
+// Returns the name of PCB state value state
+const char* pcbStateName(int state)
+{
+    switch (state)
+    {
+        case PCB_READY: return "Ready";
+        case PCB_RUNNING: return "Running";
+        case PCB_BLOCKED: return "Blocked on I/O";
+        case PCB_CANCELLED: return "Cancelled";
+        default: return "Not Found";
+    }
+}
+
 /** Prints out the following details for a completed PCB: 
  *  *  PCB Arrival Time
  *  *  PCB End Time
@@ -155,8 +301,8 @@ void printNewlyAllocatedPCB(PCB *p)
     printf("PCB Burst Time: %d\n", (p->totalBurst));
     printMemoryBlock(p->pcb_memory_block);
     MemBlock* mb = p->pcb_memory_block;
-    int fragmentation = (mb->page_size * mb->num_pages) - p->memoryNeeded;
-    printf("Fragmented Memory: %d bytes\n", fragmentation);
+    long long fragmentation = (mb->page_size * mb->num_pages) - p->memoryNeeded;
+    printf("Fragmented Memory: %lld bytes\n", fragmentation);
     printf("--------------------------\n\n");
 }
 
@@ -171,6 +317,22 @@ void printCompletedPCB(PCB *p)
     printf("PCB Arrived at time: %d\n", p->startTime);
     printf("PCB Ended at time: %d\n", p->endTime);
     printf("PCB Burst Time: %d\n", (p->totalBurst));
+    printf("PCB Time Waiting: %d\n", p->waitTime);
+    if (p->firstDispatchTime >= 0)
+    {
+        printf("PCB Response Time: %d\n", p->firstDispatchTime - p->startTime);
+    }
+    if (p->deadline > 0)
+    {
+        if (p->endTime <= p->deadlineTime)
+        {
+            printf("PCB Deadline: %d (met with %d to spare)\n", p->deadlineTime, p->deadlineTime - p->endTime);
+        }
+        else
+        {
+            printf("PCB Deadline: %d (missed by %d)\n", p->deadlineTime, p->endTime - p->deadlineTime);
+        }
+    }
     printf("PCB Memory Returned.\n");
     printf("--------------------------\n\n");
 }
@@ -0,0 +1,272 @@
+/**************************    perf_counters.h    ***************************
+*
+* Programmer:       Sean Anderson
+*
+* School:           University of Houston - Clear Lake
+*
+* Course:           CSCI 4354 - Operating Systems
+*
+* Environment:      Unix with GNU C Compiler
+*
+* Files Included:   cpu_scheduler.c, perf_counters.h
+*
+* Purpose:          Header file which contains the PerfCounters used to find out
+*                   where each clock cycle's time goes. A group of hardware
+*                   counters (cycles, instructions, cache misses and branch
+*                   misses) is opened for the calling thread with
+*                   perf_event_open, and the scheduler switches between phases
+*                   as it works. Each switch is one read() of the whole group,
+*                   whose change since the last switch is charged to the phase
+*                   that was running. Phases may nest (a writeback during
+*                   execution): perfSwitch returns the phase it replaced so the
+*                   caller can switch back.
+*
+*                   Where perf events are unavailable (no PMU, as in many VMs,
+*                   or perf_event_paranoid too high), only time is measured,
+*                   with rdtsc.
+*
+***********************************************************************/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#ifndef PERF_COUNTERS_H
+#define PERF_COUNTERS_H
+
+// Scheduler phases
+#define PHASE_NONE -1       // Between clock cycles; nothing is charged
+#define PHASE_INGEST 0
+#define PHASE_ADMISSION 1
+#define PHASE_EXECUTION 2
+#define PHASE_DISPATCH 3
+#define PHASE_WRITEBACK 4
+#define PHASE_OTHER 5       // Waking blocked PCBs, retuning the quantum
+#define NUM_PHASES 6
+
+#define NUM_COUNTERS 4
+#define PERF_CALIBRATION_READS 1000
+
+static const char *phase_names[NUM_PHASES] =
+    { "ingest", "admission", "execution", "dispatch", "writeback", "other" };
+static const char *counter_names[NUM_COUNTERS] =
+    { "cycles", "instructions", "cache-misses", "branch-misses" };
+static const unsigned long long counter_configs[NUM_COUNTERS] =
+    { PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_CACHE_MISSES,
+      PERF_COUNT_HW_BRANCH_MISSES };
+
+typedef struct perf_counters
+{
+    int fds[NUM_COUNTERS];  // fds[0] leads the group; -1 when timing with rdtsc
+    int kernel;             // 1 if time in the kernel is counted too
+    int unavailable;        // errno from perf_event_open, if it failed
+    unsigned long long last[NUM_COUNTERS];  // Counter values at the last switch
+    unsigned long long enabled, running;    // Group times, to detect multiplexing
+    int phase;              // Phase being charged, or PHASE_NONE
+    unsigned long long totals[NUM_PHASES][NUM_COUNTERS];
+
+    // Counter 0 (cycles, or TSC ticks) per phase for every clock cycle
+    unsigned long long tick[NUM_PHASES];
+    unsigned long long *samples[NUM_PHASES];
+    int numTicks;
+    int sampleCapacity;
+
+    long long switches;
+    double readNanos;       // Measured cost of one switch
+} PerfCounters;
+
+// Returns the time stamp counter, or nanoseconds where there is none.
+unsigned long long readTimestamp()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long long)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+#endif
+}
+
+/* Opens one hardware counter for the calling thread, in the group led by
+*  group_fd (-1 to lead a new, disabled group). Returns the fd, or -1.
+*/
+int openCounter(unsigned long long config, int group_fd, int kernel)
+{
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = config;
+    attr.disabled = (group_fd == -1);
+    attr.exclude_kernel = !kernel;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    return (int)syscall(__NR_perf_event_open, &attr, 0, -1, group_fd, PERF_FLAG_FD_CLOEXEC);
+}
+
+/* Reads every counter into values: the whole group with one read(), or the
+*  time stamp counter into values[0] when there is no group.
+*/
+void readCounters(PerfCounters *P, unsigned long long *values)
+{
+    if (P->fds[0] < 0)
+    {
+        values[0] = readTimestamp();
+        return;
+    }
+    unsigned long long buffer[3 + NUM_COUNTERS];
+    int i;
+    if (read(P->fds[0], buffer, sizeof(buffer)) != (ssize_t)sizeof(buffer))
+    {
+        memcpy(values, P->last, sizeof(P->last));
+        return;
+    }
+    P->enabled = buffer[1];
+    P->running = buffer[2];
+    for (i = 0; i < NUM_COUNTERS; i++)
+    {
+        values[i] = buffer[3 + i];
+    }
+}
+
+/* Charges the counts since the last switch to the current phase and makes
+*  phase (or PHASE_NONE) the current one. Returns the phase it replaced. Does
+*  nothing, and returns PHASE_NONE, if P is NULL.
+*/
+int perfSwitch(PerfCounters *P, int phase)
+{
+    if (P == NULL)
+    {
+        return PHASE_NONE;
+    }
+    unsigned long long now[NUM_COUNTERS] = { 0, 0, 0, 0 };
+    int i, previous = P->phase;
+    readCounters(P, now);
+    if (previous != PHASE_NONE)
+    {
+        for (i = 0; i < NUM_COUNTERS; i++)
+        {
+            P->totals[previous][i] += now[i] - P->last[i];
+        }
+        P->tick[previous] += now[0] - P->last[0];
+    }
+    memcpy(P->last, now, sizeof(now));
+    P->phase = phase;
+    ++P->switches;
+    return previous;
+}
+
+/* Ends a clock cycle: stops charging and records how much of counter 0 each
+*  phase used in it. Does nothing if P is NULL.
+*/
+void perfEndTick(PerfCounters *P)
+{
+    if (P == NULL)
+    {
+        return;
+    }
+    perfSwitch(P, PHASE_NONE);
+    int i;
+    if (P->numTicks == P->sampleCapacity)
+    {
+        P->sampleCapacity = (P->sampleCapacity > 0) ? P->sampleCapacity * 2 : 256;
+        for (i = 0; i < NUM_PHASES; i++)
+        {
+            P->samples[i] = (unsigned long long*)realloc(P->samples[i],
+                P->sampleCapacity * sizeof(unsigned long long));
+        }
+    }
+    for (i = 0; i < NUM_PHASES; i++)
+    {
+        P->samples[i][P->numTicks] = P->tick[i];
+        P->tick[i] = 0;
+    }
+    P->numTicks++;
+}
+
+/** Constructor for new PerfCounters on the calling thread. Counts kernel
+ *  time too if allowed, and falls back to rdtsc if no counter group can be
+ *  opened. Measures the cost of a switch before returning. */
+PerfCounters* new_PerfCounters()
+{
+    PerfCounters *P = (PerfCounters*)calloc(1, sizeof(PerfCounters));
+    int i;
+    P->phase = PHASE_NONE;
+    for (P->kernel = 1; P->kernel >= 0; P->kernel--)
+    {
+        P->fds[0] = openCounter(counter_configs[0], -1, P->kernel);
+        for (i = 1; i < NUM_COUNTERS && P->fds[0] >= 0; i++)
+        {
+            if ((P->fds[i] = openCounter(counter_configs[i], P->fds[0], P->kernel)) < 0)
+            {
+                break;
+            }
+        }
+        if (P->fds[0] >= 0 && i == NUM_COUNTERS)
+        {
+            break;
+        }
+        P->unavailable = errno;
+        while (--i >= 0)
+        {
+            if (P->fds[i] >= 0) close(P->fds[i]);
+        }
+        P->fds[0] = -1;
+    }
+    if (P->fds[0] >= 0)
+    {
+        P->unavailable = 0;
+        ioctl(P->fds[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    }
+    else
+    {
+        P->kernel = 1;  // rdtsc counts everything
+    }
+
+    // Time a batch of switches that charge nothing
+    struct timespec start, stop;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (i = 0; i < PERF_CALIBRATION_READS; i++)
+    {
+        perfSwitch(P, PHASE_NONE);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &stop);
+    P->readNanos = ((stop.tv_sec - start.tv_sec) * 1e9 + (stop.tv_nsec - start.tv_nsec)) / PERF_CALIBRATION_READS;
+    P->switches = 0;
+    return P;
+}
+
+// Orders unsigned long long samples, for percentiles
+int compareCounts(const void *a, const void *b)
+{
+    unsigned long long x = *(const unsigned long long*)a, y = *(const unsigned long long*)b;
+    return (x > y) - (x < y);
+}
+
+/* Returns the nearest-rank percentile (0 to 100) of count sorted samples,
+*  or 0 if there are none.
+*/
+unsigned long long countPercentile(const unsigned long long *sorted, int count, double percentile)
+{
+    if (count == 0)
+    {
+        return 0;
+    }
+    int rank = (int)(percentile / 100.0 * count + 0.999999);
+    if (rank < 1)
+    {
+        rank = 1;
+    }
+    return sorted[(rank > count ? count : rank) - 1];
+}
+
+#endif
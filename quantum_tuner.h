@@ -0,0 +1,152 @@
+/**************************    quantum_tuner.h    ***************************
+*
+* Programmer:       Sean Anderson
+*
+* School:           University of Houston - Clear Lake
+*
+* Course:           CSCI 4354 - Operating Systems
+*
+* Environment:      Unix with GNU C Compiler
+*
+* Files Included:   cpu_scheduler.c, quantum_tuner.h
+*
+* Purpose:          Header file which contains the QuantileEstimator used by the
+*                   adaptive round-robin quantum. It keeps a streaming estimate
+*                   of one percentile of the observed burst times using the P^2
+*                   algorithm (Jain & Chlamtac), which needs five markers and O(1)
+*                   work per sample regardless of how many bursts are seen.
+*
+***********************************************************************/
+
+#include <stdlib.h>
+#include <stdio.h>
+
+#ifndef QUANTUM_TUNER_H
+#define QUANTUM_TUNER_H
+
+typedef struct quantile_estimator
+{
+    double percentile;      // Target, between 0 and 1
+    int count;              // Samples seen so far
+    double height[5];       // Marker heights
+    double position[5];     // Actual marker positions
+    double desired[5];      // Desired marker positions
+    double increment[5];    // Desired position increment per sample
+} QuantileEstimator;
+
+// Initializes QuantileEstimator E to track the given percentile (0 to 1).
+void initQuantileEstimator(QuantileEstimator *E, double percentile)
+{
+    int i;
+    E->percentile = percentile;
+    E->count = 0;
+    for (i = 0; i < 5; i++)
+    {
+        E->height[i] = 0.0;
+        E->position[i] = i + 1;
+    }
+    E->desired[0] = 1.0;
+    E->desired[1] = 1.0 + 2.0 * percentile;
+    E->desired[2] = 1.0 + 4.0 * percentile;
+    E->desired[3] = 3.0 + 2.0 * percentile;
+    E->desired[4] = 5.0;
+    E->increment[0] = 0.0;
+    E->increment[1] = percentile / 2.0;
+    E->increment[2] = percentile;
+    E->increment[3] = (1.0 + percentile) / 2.0;
+    E->increment[4] = 1.0;
+}
+
+// Piecewise-parabolic prediction for marker i moved by d (+1 or -1).
+double parabolicHeight(QuantileEstimator *E, int i, int d)
+{
+    double *q = E->height, *n = E->position;
+    return q[i] + d / (n[i+1] - n[i-1]) *
+        ((n[i] - n[i-1] + d) * (q[i+1] - q[i]) / (n[i+1] - n[i]) +
+         (n[i+1] - n[i] - d) * (q[i] - q[i-1]) / (n[i] - n[i-1]));
+}
+
+// Adds sample x to QuantileEstimator E.
+void addQuantileSample(QuantileEstimator *E, double x)
+{
+    int i, k;
+    double *q = E->height, *n = E->position;
+
+    // The first five samples are kept sorted as the initial markers
+    if (E->count < 5)
+    {
+        for (i = E->count; i > 0 && q[i-1] > x; i--)
+        {
+            q[i] = q[i-1];
+        }
+        q[i] = x;
+        E->count++;
+        return;
+    }
+    E->count++;
+
+    // Find the cell k containing x, extending the extremes if needed
+    if (x < q[0])
+    {
+        q[0] = x;
+        k = 0;
+    }
+    else if (x >= q[4])
+    {
+        q[4] = x;
+        k = 3;
+    }
+    else
+    {
+        for (k = 0; k < 3 && x >= q[k+1]; k++);
+    }
+    for (i = k + 1; i < 5; i++)
+    {
+        n[i] += 1.0;
+    }
+    for (i = 0; i < 5; i++)
+    {
+        E->desired[i] += E->increment[i];
+    }
+
+    // Move the middle markers towards their desired positions
+    for (i = 1; i < 4; i++)
+    {
+        double gap = E->desired[i] - n[i];
+        if ((gap >= 1.0 && n[i+1] - n[i] > 1.0) || (gap <= -1.0 && n[i-1] - n[i] < -1.0))
+        {
+            int d = (gap > 0) ? 1 : -1;
+            double candidate = parabolicHeight(E, i, d);
+            if (q[i-1] < candidate && candidate < q[i+1])
+            {
+                q[i] = candidate;
+            }
+            else
+            {
+                q[i] = q[i] + d * (q[i+d] - q[i]) / (n[i+d] - n[i]);
+            }
+            n[i] += d;
+        }
+    }
+}
+
+/* Returns the current estimate of the tracked percentile, or -1 if no
+*  samples have been added.
+*/
+double getQuantileEstimate(QuantileEstimator *E)
+{
+    if (E->count == 0)
+    {
+        return -1.0;
+    }
+    if (E->count <= 5)
+    {
+        // Nearest rank over the sorted samples seen so far
+        int rank = (int)(E->percentile * E->count + 0.5);
+        if (rank < 1) rank = 1;
+        return E->height[rank - 1];
+    }
+    return E->height[2];
+}
+
+#endif
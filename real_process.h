@@ -0,0 +1,345 @@
+/**************************    real_process.h    ***************************
+*
+* Programmer:       Sean Anderson
+*
+* School:           University of Houston - Clear Lake
+*
+* Course:           CSCI 4354 - Operating Systems
+*
+* Environment:      Unix with GNU C Compiler
+*
+* Files Included:   cpu_scheduler.c, pcb_structs.h, real_process.h
+*
+* Purpose:          Header file which contains the functions used by real-process
+*                   mode, where a PCB carries a shell command that is actually run.
+*                   The command is forked into its own process group with an
+*                   address-space limit, stopped before it execs, and then given
+*                   the CPU one time slice at a time with SIGCONT and SIGSTOP.
+*                   Clocks come from a timerfd so slices are not stretched by the
+*                   time the scheduler itself spends on each clock.
+*
+*                   If asked for (-n), every command which exits is remembered,
+*                   and at shutdown the same commands are run again under plain
+*                   nice, with the same arrival offsets and limits but no
+*                   SIGSTOP/SIGCONT, so the scheduler's overhead can be reported
+*                   against what the kernel scheduler does alone. Each command
+*                   then runs twice, side effects and all.
+*
+* Trust Model:      Whoever can write a PCB to the scheduler's fifo can run any
+*                   shell command as the user running the scheduler. In
+*                   real-process mode the fifo is therefore created, or changed,
+*                   to mode 0600, and an existing fifo owned by anyone else is
+*                   refused, so only that user's own clients can submit. The
+*                   commands are not otherwise checked: run the scheduler as a
+*                   user whose rights the clients may have.
+*
+***********************************************************************/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <errno.h>
+#include <signal.h>
+#include <stdint.h>
+#include <string.h>
+#include <fcntl.h>
+#include <time.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+#include <sys/timerfd.h>
+#include "pcb_structs.h"
+
+#ifndef REAL_PROCESS_H
+#define REAL_PROCESS_H
+
+// Address space allowed on top of memoryNeeded for the shell and libc image
+#define REAL_PROCESS_BASE_AS (64LL << 20)
+
+// Niceness of the baseline runs, the default increment of nice(1)
+#define REAL_PROCESS_NICE 10
+
+// A command which exited under the scheduler, kept to be run again under nice
+typedef struct real_run
+{
+    char command[128];
+    long long addressSpace;
+    long long arrivalMicros;        // Arrival clock, in microseconds
+    long long cpuMicros;            // Child CPU time (wait4) when scheduled
+    long long turnaroundMicros;     // Arrival to exit when scheduled
+
+    // Filled in by runNiceBaseline
+    pid_t pid;
+    long long baselineCpuMicros;    // -1 if the command could not be started
+    long long baselineTurnaroundMicros;
+} RealRun;
+
+// Mode of a fifo which accepts commands to run
+#define REAL_PROCESS_FIFO_MODE 0600
+
+/* Restricts the open fifo fd to its owner, who must be this process's user,
+*  since anyone who can write to it can run commands as that user. Returns 0,
+*  or -1 (with a message) if the fifo belongs to someone else or cannot be
+*  changed.
+*/
+int restrictFifo(int fd, const char *name)
+{
+    struct stat st;
+    if (fstat(fd, &st) < 0 || !S_ISFIFO(st.st_mode) || st.st_uid != geteuid())
+    {
+        printf("%s is not a fifo owned by this user; it cannot accept commands.\n", name);
+        return -1;
+    }
+    if ((st.st_mode & 0777) != REAL_PROCESS_FIFO_MODE && fchmod(fd, REAL_PROCESS_FIFO_MODE) < 0)
+    {
+        perror("Unable to restrict FIFO");
+        return -1;
+    }
+    return 0;
+}
+
+// Returns 1 if PCB p names a command to run, 0 if its bursts are simulated.
+int isRealProcess(PCB *p)
+{
+    return p->command[0] != '\0';
+}
+
+/* Forks p->command under /bin/sh in a new process group, limited to
+*  address_space bytes (RLIMIT_AS). The child stops itself before exec, so
+*  nothing runs until the first resumeProcess. Returns the child pid, which is
+*  also stored in p->childPid, or -1 if it could not be started.
+*/
+pid_t launchProcess(PCB *p, long long address_space)
+{
+    fflush(stdout);
+    pid_t pid = fork();
+    if (pid == 0)
+    {
+        setpgid(0, 0);
+        struct rlimit limit;
+        limit.rlim_cur = (rlim_t)address_space;
+        limit.rlim_max = (rlim_t)address_space;
+        setrlimit(RLIMIT_AS, &limit);
+        raise(SIGSTOP);
+        execl("/bin/sh", "sh", "-c", p->command, (char*)NULL);
+        _exit(127);
+    }
+    if (pid < 0)
+    {
+        perror("Unable to fork process");
+        return -1;
+    }
+    setpgid(pid, pid);
+
+    // Wait until the child has stopped itself
+    int status;
+    if (waitpid(pid, &status, WUNTRACED) != pid || !WIFSTOPPED(status))
+    {
+        kill(pid, SIGKILL);
+        waitpid(pid, &status, 0);
+        return -1;
+    }
+    p->childPid = pid;
+    return pid;
+}
+
+// Lets the process group of PCB p run.
+void resumeProcess(PCB *p)
+{
+    kill(-p->childPid, SIGCONT);
+}
+
+// Stops the process group of PCB p at the end of its time slice.
+void suspendProcess(PCB *p)
+{
+    kill(-p->childPid, SIGSTOP);
+}
+
+/* Checks whether the process of PCB p has exited, waiting for it if options
+*  does not include WNOHANG. On exit, stores its exit status (or 128 + signal)
+*  in p->exitStatus and its user + system CPU time from wait4 in p->cpuMicros,
+*  clears p->childPid and returns 1. Otherwise returns 0.
+*/
+int reapProcess(PCB *p, int options)
+{
+    int status;
+    struct rusage usage;
+    if (wait4(p->childPid, &status, options, &usage) != p->childPid)
+    {
+        return 0;
+    }
+    if (WIFSTOPPED(status) || WIFCONTINUED(status))
+    {
+        return 0;
+    }
+    p->exitStatus = WIFEXITED(status) ? WEXITSTATUS(status) : 128 + WTERMSIG(status);
+    p->cpuMicros = (long long)(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000000LL +
+        usage.ru_utime.tv_usec + usage.ru_stime.tv_usec;
+    p->childPid = 0;
+    return 1;
+}
+
+/* Kills the whole process group of PCB p and reaps it. Does nothing if it
+*  has no live process.
+*/
+void killProcess(PCB *p)
+{
+    if (p->childPid <= 0)
+    {
+        return;
+    }
+    kill(-p->childPid, SIGKILL);
+    if (!reapProcess(p, 0))
+    {
+        p->childPid = 0;
+    }
+}
+
+// Returns CLOCK_MONOTONIC in microseconds
+long long monotonicMicros()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000LL + ts.tv_nsec / 1000;
+}
+
+// Orders RealRuns by arrival
+int compareRealRuns(const void *a, const void *b)
+{
+    long long x = ((const RealRun*)a)->arrivalMicros, y = ((const RealRun*)b)->arrivalMicros;
+    return (x > y) - (x < y);
+}
+
+/* Runs the count commands in runs again as the kernel alone would: each one
+*  is started at its arrival offset from the first, under nice with its
+*  address-space limit and output discarded, and never stopped. Every one is
+*  reaped by its pid with wait4 for its CPU time; its turnaround runs from its
+*  arrival offset to its exit. SIGCHLD is held while they run so the wait for
+*  the next exit or arrival can sleep in sigtimedwait. Sorts runs by arrival.
+*/
+void runNiceBaseline(RealRun *runs, int count)
+{
+    if (count == 0)
+    {
+        return;
+    }
+    qsort(runs, count, sizeof(RealRun), compareRealRuns);
+    sigset_t child_set, old_set;
+    sigemptyset(&child_set);
+    sigaddset(&child_set, SIGCHLD);
+    sigprocmask(SIG_BLOCK, &child_set, &old_set);
+    long long first = runs[0].arrivalMicros, start = monotonicMicros();
+    int launched = 0, running = 0, i;
+    fflush(stdout);
+    while (launched < count || running > 0)
+    {
+        long long now = monotonicMicros() - start;
+        for ( ; launched < count && runs[launched].arrivalMicros - first <= now; launched++)
+        {
+            RealRun *R = &runs[launched];
+            R->baselineCpuMicros = -1;
+            R->pid = fork();
+            if (R->pid == 0)
+            {
+                struct rlimit limit;
+                int null_fd = open("/dev/null", O_WRONLY);
+                dup2(null_fd, STDOUT_FILENO);
+                dup2(null_fd, STDERR_FILENO);
+                limit.rlim_cur = (rlim_t)R->addressSpace;
+                limit.rlim_max = (rlim_t)R->addressSpace;
+                setrlimit(RLIMIT_AS, &limit);
+                sigprocmask(SIG_SETMASK, &old_set, NULL);
+                errno = 0;
+                if (nice(REAL_PROCESS_NICE) == -1 && errno != 0)
+                {
+                    _exit(127);
+                }
+                execl("/bin/sh", "sh", "-c", R->command, (char*)NULL);
+                _exit(127);
+            }
+            if (R->pid > 0)
+            {
+                running++;
+            }
+            else
+            {
+                R->pid = 0;
+            }
+        }
+
+        // Reap whichever of ours have exited
+        for (i = 0; i < launched; i++)
+        {
+            int status;
+            struct rusage usage;
+            if (runs[i].pid > 0 && wait4(runs[i].pid, &status, WNOHANG, &usage) == runs[i].pid)
+            {
+                runs[i].baselineCpuMicros = (long long)(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000000LL +
+                    usage.ru_utime.tv_usec + usage.ru_stime.tv_usec;
+                runs[i].baselineTurnaroundMicros = monotonicMicros() - start - (runs[i].arrivalMicros - first);
+                runs[i].pid = 0;
+                running--;
+            }
+        }
+
+        // Sleep until a child exits or the next command is due
+        if (running > 0 || launched < count)
+        {
+            long long wait_micros = 1000000LL;
+            if (launched < count)
+            {
+                wait_micros = runs[launched].arrivalMicros - first - (monotonicMicros() - start);
+                wait_micros = (wait_micros > 0) ? wait_micros : 0;
+            }
+            struct timespec timeout;
+            timeout.tv_sec = wait_micros / 1000000LL;
+            timeout.tv_nsec = (wait_micros % 1000000LL) * 1000L;
+            sigtimedwait(&child_set, NULL, &timeout);
+        }
+    }
+    sigprocmask(SIG_SETMASK, &old_set, NULL);
+}
+
+/* Creates a timerfd that fires every tick_ms milliseconds. Returns the fd,
+*  or -1 on failure.
+*/
+int openTickTimer(int tick_ms)
+{
+    int fd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC);
+    if (fd < 0)
+    {
+        perror("Unable to create tick timer");
+        return -1;
+    }
+    struct itimerspec spec;
+    spec.it_interval.tv_sec = tick_ms / 1000;
+    spec.it_interval.tv_nsec = (long)(tick_ms % 1000) * 1000000L;
+    spec.it_value = spec.it_interval;
+    if (timerfd_settime(fd, 0, &spec, NULL) < 0)
+    {
+        perror("Unable to start tick timer");
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+/* Blocks until the next tick of timerfd fd. Returns the number of ticks
+*  elapsed since the last call (more than 1 if clocks were missed).
+*/
+int waitForTick(int fd)
+{
+    uint64_t ticks = 0;
+    while (read(fd, &ticks, sizeof(ticks)) != sizeof(ticks))
+    {
+        if (errno != EINTR)
+        {
+            return 1;
+        }
+    }
+    return (int)ticks;
+}
+
+#endif
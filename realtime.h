@@ -0,0 +1,264 @@
+/**************************    realtime.h    ***************************
+*
+* Programmer:       Sean Anderson
+*
+* School:           University of Houston - Clear Lake
+*
+* Course:           CSCI 4354 - Operating Systems
+*
+* Environment:      Unix with GNU C Compiler
+*
+* Files Included:   cpu_scheduler.c, pcb_structs.h, realtime.h
+*
+* Purpose:          Header file which contains the EdfQueue, the run queue of
+*                   the real-time class. PCBs with a deadline are kept in a
+*                   binary min-heap on their absolute deadline (earliest deadline
+*                   first), so a push, a pop or the removal of a cancelled PCB is
+*                   O(log n): each PCB remembers its place in the heap.
+*
+*                   Admission control reserves each real-time PCB's density (CPU
+*                   clocks needed / clocks until its deadline, in parts per
+*                   million) from its arrival until its deadline. A PCB is only
+*                   admitted if the reserved densities stay within the capacity,
+*                   which is enough for EDF to meet every deadline. Reservations
+*                   are held in a second min-heap, on deadline, so expired ones
+*                   are dropped in order and the time integral of the reservation
+*                   (the CPU share promised away from best-effort work) is exact.
+*
+***********************************************************************/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include "pcb_structs.h"
+
+#ifndef REALTIME_H
+#define REALTIME_H
+
+#define RT_PPM 1000000LL    // Density of a PCB that needs the whole CPU
+
+// Returns 1 if PCB p has a deadline, 0 if it is best-effort work.
+int isRealTime(PCB *p)
+{
+    return p->deadline > 0;
+}
+
+// A PCB on the EdfQueue. pcb comes first, so a PCB* from edfPush is the node.
+typedef struct edf_node
+{
+    PCB pcb;
+    int position;           // Index in heap
+} EdfNode;
+
+typedef struct rt_reservation
+{
+    int deadline;
+    long long density;      // Parts per million of the CPU
+} RtReservation;
+
+typedef struct edf_queue
+{
+    PCB **heap;             // Ready real-time PCBs, min-heap on deadlineTime
+    int size;
+    int capacity;
+
+    RtReservation *reservations;    // Min-heap on deadline
+    int numReservations;
+    int reservationCapacity;
+    long long maxDensity;   // Total density that may be reserved
+    long long reserved;     // Total density reserved now
+    long long peakReserved;
+    long long reservedArea; // Reserved density summed over clocks
+    int lastUpdate;         // Clock reservedArea runs to
+
+    // Real-time class statistics
+    int admitted;
+    int rejected;
+    int completed;
+    int misses;
+    long long totalLateness;
+    int maxLateness;
+    int cpuTime;
+    int preemptions;
+} EdfQueue;
+
+/** Constructor for a new, empty EdfQueue which may reserve up to
+ *  maxDensity parts per million of the CPU. */
+EdfQueue* new_EdfQueue(long long maxDensity)
+{
+    EdfQueue *Q = (EdfQueue*)calloc(1, sizeof(EdfQueue));
+    Q->capacity = 16;
+    Q->heap = (PCB**)malloc(Q->capacity * sizeof(PCB*));
+    Q->reservationCapacity = 16;
+    Q->reservations = (RtReservation*)malloc(Q->reservationCapacity * sizeof(RtReservation));
+    Q->maxDensity = maxDensity;
+    return Q;
+}
+
+// Returns 1 if PCB a must run before PCB b: earlier deadline, then earlier arrival
+int edfBefore(PCB *a, PCB *b)
+{
+    if (a->deadlineTime != b->deadlineTime)
+    {
+        return a->deadlineTime < b->deadlineTime;
+    }
+    return a->startTime < b->startTime || (a->startTime == b->startTime && a->pcbnumber < b->pcbnumber);
+}
+
+// Puts PCB p, a pointer returned by edfPush, at position i of the heap
+void placeEdf(EdfQueue *Q, int i, PCB *p)
+{
+    Q->heap[i] = p;
+    ((EdfNode*)p)->position = i;
+}
+
+// Restores the heap order around position i
+void siftEdf(EdfQueue *Q, int i)
+{
+    PCB *temp;
+    while (i > 0 && edfBefore(Q->heap[i], Q->heap[(i - 1) / 2]))
+    {
+        temp = Q->heap[i];
+        placeEdf(Q, i, Q->heap[(i - 1) / 2]);
+        placeEdf(Q, (i - 1) / 2, temp);
+        i = (i - 1) / 2;
+    }
+    for (;;)
+    {
+        int first = i, left = 2 * i + 1, right = 2 * i + 2;
+        if (left < Q->size && edfBefore(Q->heap[left], Q->heap[first])) first = left;
+        if (right < Q->size && edfBefore(Q->heap[right], Q->heap[first])) first = right;
+        if (first == i)
+        {
+            break;
+        }
+        temp = Q->heap[i];
+        placeEdf(Q, i, Q->heap[first]);
+        placeEdf(Q, first, temp);
+        i = first;
+    }
+}
+
+/** Pushes a copy of PCB p onto the heap and returns the copy. */
+PCB* edfPush(EdfQueue *Q, PCB *p)
+{
+    if (Q->size == Q->capacity)
+    {
+        Q->capacity *= 2;
+        Q->heap = (PCB**)realloc(Q->heap, Q->capacity * sizeof(PCB*));
+    }
+    EdfNode *node = (EdfNode*)malloc(sizeof(EdfNode));
+    node->pcb = *p;
+    placeEdf(Q, Q->size++, &node->pcb);
+    siftEdf(Q, Q->size - 1);
+    return &node->pcb;
+}
+
+/** Returns the PCB with the earliest deadline without removing it, or NULL. */
+PCB* edfPeek(EdfQueue *Q)
+{
+    return (Q->size > 0) ? Q->heap[0] : NULL;
+}
+
+/** Removes PCB p, a pointer returned by edfPush, from the heap and returns
+ *  it, or NULL if it is not there. The caller frees it. */
+PCB* edfRemove(EdfQueue *Q, PCB *p)
+{
+    int i = ((EdfNode*)p)->position;
+    if (i < 0 || i >= Q->size || Q->heap[i] != p)
+    {
+        return NULL;
+    }
+    ((EdfNode*)p)->position = -1;
+    Q->size--;
+    if (i < Q->size)
+    {
+        placeEdf(Q, i, Q->heap[Q->size]);
+        siftEdf(Q, i);
+    }
+    return p;
+}
+
+/** Pops the PCB with the earliest deadline, or returns NULL if the heap is
+ *  empty. The caller frees it. */
+PCB* edfPop(EdfQueue *Q)
+{
+    return (Q->size > 0) ? edfRemove(Q, Q->heap[0]) : NULL;
+}
+
+// Restores the reservation heap order around position i
+void siftReservation(EdfQueue *Q, int i)
+{
+    RtReservation temp, *R = Q->reservations;
+    while (i > 0 && R[i].deadline < R[(i - 1) / 2].deadline)
+    {
+        temp = R[i];
+        R[i] = R[(i - 1) / 2];
+        R[(i - 1) / 2] = temp;
+        i = (i - 1) / 2;
+    }
+    for (;;)
+    {
+        int first = i, left = 2 * i + 1, right = 2 * i + 2;
+        if (left < Q->numReservations && R[left].deadline < R[first].deadline) first = left;
+        if (right < Q->numReservations && R[right].deadline < R[first].deadline) first = right;
+        if (first == i)
+        {
+            break;
+        }
+        temp = R[i];
+        R[i] = R[first];
+        R[first] = temp;
+        i = first;
+    }
+}
+
+/** Advances the reservations to clock now, releasing every one whose
+ *  deadline has passed and adding up the density reserved on the way. */
+void advanceReservations(EdfQueue *Q, int now)
+{
+    while (Q->numReservations > 0 && Q->reservations[0].deadline <= now)
+    {
+        RtReservation *R = &Q->reservations[0];
+        if (R->deadline > Q->lastUpdate)
+        {
+            Q->reservedArea += Q->reserved * (R->deadline - Q->lastUpdate);
+            Q->lastUpdate = R->deadline;
+        }
+        Q->reserved -= R->density;
+        Q->reservations[0] = Q->reservations[--Q->numReservations];
+        siftReservation(Q, 0);
+    }
+    if (now > Q->lastUpdate)
+    {
+        Q->reservedArea += Q->reserved * (now - Q->lastUpdate);
+        Q->lastUpdate = now;
+    }
+}
+
+/** Reserves density until deadline if it fits within the capacity at clock
+ *  now. Returns 1 if it was reserved, 0 if the PCB must be rejected. */
+int reserveDensity(EdfQueue *Q, int now, int deadline, long long density)
+{
+    advanceReservations(Q, now);
+    if (deadline <= now || Q->reserved + density > Q->maxDensity)
+    {
+        return 0;
+    }
+    if (Q->numReservations == Q->reservationCapacity)
+    {
+        Q->reservationCapacity *= 2;
+        Q->reservations = (RtReservation*)realloc(Q->reservations,
+            Q->reservationCapacity * sizeof(RtReservation));
+    }
+    Q->reservations[Q->numReservations].deadline = deadline;
+    Q->reservations[Q->numReservations].density = density;
+    siftReservation(Q, Q->numReservations++);
+    Q->reserved += density;
+    if (Q->reserved > Q->peakReserved)
+    {
+        Q->peakReserved = Q->reserved;
+    }
+    return 1;
+}
+
+#endif
@@ -0,0 +1,151 @@
+/**************************    shard_load.h    ***************************
+*
+* Programmer:       Sean Anderson
+*
+* School:           University of Houston - Clear Lake
+*
+* Course:           CSCI 4354 - Operating Systems
+*
+* Environment:      Unix with GNU C Compiler
+*
+* Files Included:   cpu_scheduler.c, dispatcher.c, shard_load.h
+*
+* Purpose:          Header file which contains the load channel between the
+*                   dispatcher and its CPU_Scheduler shards: a small file,
+*                   memory mapped by every process, holding one ShardLoad slot
+*                   per shard. Each shard rewrites its own slot once per clock
+*                   (free pages, queue depths and how many PCBs it has read);
+*                   the dispatcher reads every slot before routing a PCB. A
+*                   slot has a single writer and is guarded by a sequence count
+*                   (odd while it is being written), so a reader never uses a
+*                   half-written slot and neither side ever takes a lock or
+*                   makes a system call. Slots are cache-line sized, so shards
+*                   do not slow each other down by writing neighbouring slots.
+*
+* Load File:        LoadHeader (64 bytes), then one ShardLoad (64 bytes) per shard.
+*
+***********************************************************************/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+
+#ifndef SHARD_LOAD_H
+#define SHARD_LOAD_H
+
+#define LOAD_MAGIC 0x44414F4C // "LOAD"
+#define LOAD_VERSION 1
+
+typedef struct load_header
+{
+    int magic;
+    int version;
+    int shards;
+    int reserved;
+    char unused[48];        // Pads the header to 64 bytes
+} LoadHeader;
+
+typedef struct shard_load
+{
+    unsigned int sequence;  // Odd while the slot is being written
+    pid_t pid;              // Shard process, 0 until it is serving
+    int clock;
+    int ready;              // PCBs in its ready queues
+    int blocked;
+    int running;
+    long long pageSize;
+    long long freePages;
+    long long received;     // Submissions read from its fifo so far
+    long long receivedPages;    // Pages those submissions asked for
+    long long completed;
+} __attribute__((aligned(64))) ShardLoad;
+
+/* Maps the load channel at path. The dispatcher creates it with create set,
+*  sized for shards slots, all zero; a shard maps the existing file and gets
+*  back the number of slots in *shards. Returns the first slot, or NULL.
+*/
+ShardLoad* mapLoadChannel(const char *path, int *shards, int create)
+{
+    int fd = open(path, create ? (O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC) : (O_RDWR | O_CLOEXEC), 0644);
+    LoadHeader header;
+    if (fd < 0)
+    {
+        perror("Unable to open load channel");
+        return NULL;
+    }
+    if (create)
+    {
+        memset(&header, 0, sizeof(header));
+        header.magic = LOAD_MAGIC;
+        header.version = LOAD_VERSION;
+        header.shards = *shards;
+        if (ftruncate(fd, sizeof(LoadHeader) + (size_t)*shards * sizeof(ShardLoad)) < 0 ||
+            pwrite(fd, &header, sizeof(header), 0) != sizeof(header))
+        {
+            perror("Unable to size load channel");
+            close(fd);
+            return NULL;
+        }
+    }
+    else if (pread(fd, &header, sizeof(header), 0) != sizeof(header) || header.magic != LOAD_MAGIC ||
+        header.version != LOAD_VERSION || header.shards < 1)
+    {
+        printf("%s is not a load channel.\n", path);
+        close(fd);
+        return NULL;
+    }
+    *shards = header.shards;
+    size_t bytes = sizeof(LoadHeader) + (size_t)header.shards * sizeof(ShardLoad);
+    char *base = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED)
+    {
+        perror("Unable to map load channel");
+        return NULL;
+    }
+    return (ShardLoad*)(base + sizeof(LoadHeader));
+}
+
+/* Returns the pages a submission of memoryNeeded bytes counts for in sent and
+*  received pages: rounded up to whole pages without overflowing, or 0 for a
+*  negative size, which no shard admits.
+*/
+long long submissionPages(long long memoryNeeded, long long pageSize)
+{
+    if (memoryNeeded < 0 || pageSize < 1)
+    {
+        return 0;
+    }
+    return memoryNeeded / pageSize + (memoryNeeded % pageSize != 0);
+}
+
+// Publishes values into slot. Only the shard owning slot may call this.
+void storeShardLoad(ShardLoad *slot, const ShardLoad *values)
+{
+    unsigned int sequence = slot->sequence;
+    __atomic_store_n(&slot->sequence, sequence + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    memcpy((char*)slot + sizeof(slot->sequence), (const char*)values + sizeof(values->sequence),
+        sizeof(ShardLoad) - sizeof(slot->sequence));
+    __atomic_store_n(&slot->sequence, sequence + 2, __ATOMIC_RELEASE);
+}
+
+// Copies a consistent view of slot into out, retrying while it is rewritten.
+void loadShardLoad(ShardLoad *slot, ShardLoad *out)
+{
+    unsigned int before, after;
+    do
+    {
+        before = __atomic_load_n(&slot->sequence, __ATOMIC_ACQUIRE);
+        memcpy(out, slot, sizeof(ShardLoad));
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        after = __atomic_load_n(&slot->sequence, __ATOMIC_RELAXED);
+    } while ((before & 1) || before != after);
+}
+
+#endif
@@ -0,0 +1,306 @@
+/**************************    snapshot.h    ***************************
+*
+* Programmer:       Sean Anderson
+*
+* School:           University of Houston - Clear Lake
+*
+* Course:           CSCI 4354 - Operating Systems
+*
+* Environment:      Unix with GNU C Compiler
+*
+* Files Included:   cpu_scheduler.c, pcb_client.c, pcb_structs.h, mem_structs.h,
+*                   snapshot.h, quantum_tuner.h, timing_wheel.h
+*
+* Purpose:          Header file which saves and restores the complete state of the
+*                   CPU Scheduler so that a restart can resume in-flight work
+*                   instead of returning it to the clients.
+*
+* File Layout:      SnapshotHeader
+*                   has_running + ready_count + blocked_count PCB records, running
+*                   PCB first, then ready in queue order, then blocked on I/O:
+*                       PCB, page count, page start addresses
+*                   free_list_count returned page start addresses
+*
+*                   All records are fixed-width so the file is read back in place
+*                   through a single read-only memory map.
+*
+***********************************************************************/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "pcb_structs.h"
+#include "mem_structs.h"
+#include "quantum_tuner.h"
+#include "timing_wheel.h"
+
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#define SNAPSHOT_MAGIC 0x50435353 // "PCSS"
+#define SNAPSHOT_VERSION 11
+
+typedef struct snapshot_header
+{
+    int magic;
+    int version;
+
+    // CPU statistic and scheduling variables
+    int cpu_clock;
+    int active_cpu_time;
+    int time_waiting_in_ready;
+    long long total_response_time;
+    int responded_tasks;
+    int total_turnaround_time;
+    int completed_tasks;
+    int cancelled_tasks;
+    int io_blocks;
+    int io_overlap_cycles;
+    int admitted_tasks;
+    int rejected_tasks;
+    long long total_fragmentation;
+    int round_robin_max;
+    int remaining_rr_time;
+    int context_switches;
+    int voluntary_preemptions;
+    int involuntary_preemptions;
+    int switch_overhead_remaining;
+    int overhead_cycles;
+    pid_t last_run_pcb;     // pcbnumber, not a process id
+    int quantum_changes;
+    QuantileEstimator burst_estimator;
+
+    // PCB records which follow the header
+    int has_running;
+    int ready_count;
+    int blocked_count;
+
+    // MemQueue geometry and free pages
+    long long page_size;
+    long long total_size;
+    long long next_unused_address;
+    long long free_pages;
+    long long free_list_count;
+} SnapshotHeader;
+
+// Writes one PCB record: the PCB, its page count and its page addresses.
+void writeSnapshotPCB(FILE *out, PCB *p)
+{
+    long long i;
+    MemBlock *mb = p->pcb_memory_block;
+    fwrite(p, sizeof(PCB), 1, out);
+    fwrite(&mb->num_pages, sizeof(long long), 1, out);
+    for (i = 0; i < mb->num_pages; i++)
+    {
+        fwrite(&mb->memory_block[i].memory_start_address, sizeof(long long), 1, out);
+    }
+}
+
+/* Saves the scheduler state to path. The header must already hold the CPU
+*  statistic variables; the queue and memory fields are filled in here. The
+*  file is written beside path and renamed into place so that a crash while
+*  saving never leaves a partial snapshot. Returns 0 on success, -1 on fail.
+*/
+int saveSnapshot(const char *path, SnapshotHeader *h, PCB *running, pcb_queue *Q, TimingWheel *W,
+    MemQueue *mem)
+{
+    char temp_path[256];
+    snprintf(temp_path, sizeof(temp_path), "%s.tmp", path);
+    FILE *out = fopen(temp_path, "wb");
+    if (out == NULL)
+    {
+        perror("Unable to write snapshot");
+        return -1;
+    }
+
+    h->magic = SNAPSHOT_MAGIC;
+    h->version = SNAPSHOT_VERSION;
+    h->has_running = (running != NULL);
+    h->ready_count = Q->size;
+    h->blocked_count = W->size;
+    h->page_size = mem->PageFile_size;
+    h->total_size = mem->total_size;
+    h->next_unused_address = mem->next_unused_address;
+    h->free_pages = mem->size;
+    h->free_list_count = mem->size - (mem->total_size - mem->next_unused_address) / mem->PageFile_size;
+    fwrite(h, sizeof(SnapshotHeader), 1, out);
+
+    if (running != NULL)
+    {
+        writeSnapshotPCB(out, running);
+    }
+    pcb_node *n;
+    for (n = Q->head; n != NULL; n = n->next)
+    {
+        writeSnapshotPCB(out, &n->element);
+    }
+    int level, slot;
+    WheelNode *w;
+    for (level = 0; level < WHEEL_LEVELS; level++)
+    {
+        for (slot = 0; slot < WHEEL_SLOTS; slot++)
+        {
+            for (w = W->slots[level][slot]; w != NULL; w = w->next)
+            {
+                writeSnapshotPCB(out, &w->element);
+            }
+        }
+    }
+    MemNode *m;
+    for (m = mem->first; m != NULL; m = m->next)
+    {
+        fwrite(&m->memory.memory_start_address, sizeof(long long), 1, out);
+    }
+
+    int failed = ferror(out);
+    failed |= fflush(out);
+    failed |= fsync(fileno(out));
+    failed |= fclose(out);
+    if (failed || rename(temp_path, path) < 0)
+    {
+        perror("Unable to write snapshot");
+        unlink(temp_path);
+        return -1;
+    }
+    return 0;
+}
+
+/* Reads one PCB record starting at *cursor into a newly allocated PCB and
+*  MemBlock, and advances *cursor past it. Returns NULL if the record runs
+*  past end.
+*/
+PCB* readSnapshotPCB(const char **cursor, const char *end, long long page_size)
+{
+    long long num_pages, i;
+    if (*cursor + sizeof(PCB) + sizeof(long long) > end)
+    {
+        return NULL;
+    }
+    PCB *p = (PCB*)malloc(sizeof(PCB));
+    memcpy(p, *cursor, sizeof(PCB));
+    *cursor += sizeof(PCB);
+    memcpy(&num_pages, *cursor, sizeof(long long));
+    *cursor += sizeof(long long);
+    if (num_pages < 0 || num_pages > (end - *cursor) / (long long)sizeof(long long))
+    {
+        free(p);
+        return NULL;
+    }
+
+    MemBlock *mb = new_MemBlock(num_pages, page_size);
+    if (mb == NULL)
+    {
+        free(p);
+        return NULL;
+    }
+    for (i = 0; i < num_pages; i++)
+    {
+        memcpy(&mb->memory_block[i].memory_start_address, *cursor, sizeof(long long));
+        *cursor += sizeof(long long);
+    }
+    p->pcb_memory_block = mb;
+    return p;
+}
+
+/* Restores the scheduler state saved at path. On success fills h, sets
+*  *running, enqueues the ready PCBs onto Q in their saved order, moves W to
+*  the saved clock and inserts the blocked PCBs into it, replaces
+*  *mem with the saved MemQueue and removes the snapshot so it is never
+*  replayed twice. Returns 0 on success, -1 if there is no usable snapshot.
+*/
+int loadSnapshot(const char *path, SnapshotHeader *h, PCB **running, pcb_queue *Q, TimingWheel *W,
+    MemQueue **mem)
+{
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+    {
+        return -1;
+    }
+    struct stat st;
+    if (fstat(fd, &st) < 0 || st.st_size < (off_t)sizeof(SnapshotHeader))
+    {
+        close(fd);
+        return -1;
+    }
+    const char *base = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED)
+    {
+        perror("Unable to map snapshot");
+        return -1;
+    }
+    const char *end = base + st.st_size;
+    const char *cursor = base;
+
+    memcpy(h, cursor, sizeof(SnapshotHeader));
+    cursor += sizeof(SnapshotHeader);
+    if (h->magic != SNAPSHOT_MAGIC || h->version != SNAPSHOT_VERSION)
+    {
+        printf("Snapshot %s is not compatible. Starting fresh.\n", path);
+        munmap((void*)base, st.st_size);
+        return -1;
+    }
+
+    // Read every PCB record before touching the caller's state
+    int i, count = h->has_running + h->ready_count + h->blocked_count;
+    long long j, address;
+    PCB **pcbs = (PCB**)malloc((count > 0 ? count : 1) * sizeof(PCB*));
+    for (i = 0; i < count; i++)
+    {
+        if ((pcbs[i] = readSnapshotPCB(&cursor, end, h->page_size)) == NULL)
+        {
+            break;
+        }
+    }
+    if (i < count || end - cursor != h->free_list_count * (long long)sizeof(long long))
+    {
+        printf("Snapshot %s is truncated. Starting fresh.\n", path);
+        while (i-- > 0)
+        {
+            free(pcbs[i]->pcb_memory_block);
+            free(pcbs[i]);
+        }
+        free(pcbs);
+        munmap((void*)base, st.st_size);
+        return -1;
+    }
+
+    // Rebuild the MemQueue: untouched region first, then the returned pages
+    MemQueue *M = new_MemQueue(h->total_size, h->page_size);
+    M->next_unused_address = h->next_unused_address;
+    M->size = (h->total_size - h->next_unused_address) / h->page_size;
+    for (j = 0; j < h->free_list_count; j++)
+    {
+        memcpy(&address, cursor, sizeof(long long));
+        cursor += sizeof(long long);
+        enqueueNode(M, address);
+    }
+    munmap((void*)base, st.st_size);
+
+    *running = h->has_running ? pcbs[0] : NULL;
+    for (i = h->has_running; i < h->has_running + h->ready_count; i++)
+    {
+        enqueue(Q, *pcbs[i]);
+        free(pcbs[i]);
+    }
+    // cpu_clock is the first clock not yet run, so the wheel last advanced to
+    // the clock before it; the next cycle then expires cpu_clock's slot
+    W->now = h->cpu_clock - 1;
+    for ( ; i < count; i++)
+    {
+        insertTimingWheel(W, *pcbs[i]);
+        free(pcbs[i]);
+    }
+    free(pcbs);
+
+    free(*mem);
+    *mem = M;
+    unlink(path);
+    return 0;
+}
+
+#endif
@@ -0,0 +1,82 @@
+/**************************    static_config.h    ***************************
+*
+* Programmer:       Sean Anderson
+*
+* School:           University of Houston - Clear Lake
+*
+* Course:           CSCI 4354 - Operating Systems
+*
+* Environment:      Unix with GNU C Compiler
+*
+* Files Included:   cpu_scheduler.c, mem_structs.h, static_config.h
+*
+* Purpose:          Header file which contains the parameters of the statically
+*                   configured scheduler build. Compiled with -DSCHED_STATIC_CONFIG,
+*                   the page size, memory size, round robin quantum, core count
+*                   and admission policy are fixed when the scheduler is built
+*                   instead of being read from the command line:
+*
+*                       SCHED_PAGE_SHIFT        log2 of the page size (default 6, 64 bytes)
+*                       SCHED_MEMORY_SHIFT      log2 of the memory size (default 10, 1K)
+*                       SCHED_QUANTUM           round robin quantum (default 4)
+*                       SCHED_CORES             sweep configurations run at once (default 1)
+*                       SCHED_ADMISSION_POLICY  -1 for one PCB at a time (default), or
+*                                               ADMIT_FIFO, ADMIT_SMALLEST, ADMIT_MAXCOUNT
+*
+*                   e.g. gcc -O2 -DSCHED_STATIC_CONFIG -DSCHED_PAGE_SHIFT=12
+*                        -DSCHED_MEMORY_SHIFT=30 -o cpu_scheduler cpu_scheduler.c -lm
+*
+*                   Page counts then become shifts and masks by constants, the
+*                   free page list draws from a fixed pool of nodes, and the
+*                   quantum and policy fold into the code that uses them. Without
+*                   SCHED_STATIC_CONFIG every one of these is read from the
+*                   MemQueue or a global, as before.
+*
+***********************************************************************/
+
+#ifndef STATIC_CONFIG_H
+#define STATIC_CONFIG_H
+
+#ifdef SCHED_STATIC_CONFIG
+
+#ifndef SCHED_PAGE_SHIFT
+#define SCHED_PAGE_SHIFT 6
+#endif
+#ifndef SCHED_MEMORY_SHIFT
+#define SCHED_MEMORY_SHIFT 10
+#endif
+#ifndef SCHED_QUANTUM
+#define SCHED_QUANTUM 4
+#endif
+#ifndef SCHED_CORES
+#define SCHED_CORES 1
+#endif
+#ifndef SCHED_ADMISSION_POLICY
+#define SCHED_ADMISSION_POLICY -1
+#endif
+
+#if SCHED_PAGE_SHIFT < 0 || SCHED_MEMORY_SHIFT < 1 || SCHED_MEMORY_SHIFT < SCHED_PAGE_SHIFT || SCHED_MEMORY_SHIFT > 62
+#error "SCHED_MEMORY_SHIFT must be at least SCHED_PAGE_SHIFT, and between 1 and 62"
+#endif
+#if SCHED_QUANTUM < 1 || SCHED_CORES < 1
+#error "SCHED_QUANTUM and SCHED_CORES must be positive"
+#endif
+
+#define SCHED_PAGE_SIZE (1LL << SCHED_PAGE_SHIFT)
+#define SCHED_TOTAL_MEMORY (1LL << SCHED_MEMORY_SHIFT)
+#define SCHED_TOTAL_PAGES (1LL << (SCHED_MEMORY_SHIFT - SCHED_PAGE_SHIFT))
+
+// Page geometry of a MemQueue
+#define MEM_PAGE_SHIFT(Q) SCHED_PAGE_SHIFT
+#define MEM_PAGE_SIZE(Q) SCHED_PAGE_SIZE
+#define MEM_PAGE_MASK(Q) (SCHED_PAGE_SIZE - 1)
+
+#else
+
+#define MEM_PAGE_SHIFT(Q) ((Q)->page_shift)
+#define MEM_PAGE_SIZE(Q) ((Q)->PageFile_size)
+#define MEM_PAGE_MASK(Q) ((Q)->page_mask)
+
+#endif
+
+#endif
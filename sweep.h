@@ -0,0 +1,380 @@
+/**************************    sweep.h    ***************************
+*
+* Programmer:       Sean Anderson
+*
+* School:           University of Houston - Clear Lake
+*
+* Course:           CSCI 4354 - Operating Systems
+*
+* Environment:      Unix with GNU C Compiler
+*
+* Files Included:   cpu_scheduler.c, mem_structs.h, pcb_structs.h, sweep.h
+*
+* Purpose:          Header file which contains the Workload, SampleList and
+*                   SweepResult types and the parameter-sweep runner. The runner
+*                   forks one scheduler instance per (total memory, page size,
+*                   quantum) configuration, keeping as many running as requested,
+*                   so every instance has its own copy of the scheduler's globals
+*                   and nothing is shared between them. Each instance reports one
+*                   SweepResult back through a pipe and the runner prints them as
+*                   CSV in configuration order.
+*
+* Workload File:    One PCB per line: arrival_clock burst memory_needed [io burst ...]
+*                   Memory accepts size suffixes (e.g. 16K). Optional trailing
+*                   pairs add an I/O burst followed by another CPU burst. Lines
+*                   starting with '#' are ignored.
+*
+***********************************************************************/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <limits.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include "mem_structs.h"
+#include "pcb_structs.h"
+
+#ifndef SWEEP_H
+#define SWEEP_H
+
+#define MAX_SWEEP_VALUES 64
+
+// Workload struct: PCB arrivals sorted by arrival clock
+typedef struct workload
+{
+    int count;
+    int *arrival;
+    int *num_bursts;
+    int (*bursts)[MAX_BURSTS];
+    long long *memory;
+} Workload;
+
+// SampleList struct: growable list of integer samples
+typedef struct sample_list
+{
+    int count;
+    int capacity;
+    int *values;
+} SampleList;
+
+// SweepResult struct: one CSV row, written from child to parent
+typedef struct sweep_result
+{
+    long long total_memory;
+    long long page_size;
+    int round_robin;
+    int clocks;
+    int completed;
+    int rejected;
+    int context_switches;
+    double utilization;
+    double average_turnaround;
+    double turnaround_p50;
+    double turnaround_p90;
+    double turnaround_p99;
+    double average_wait;
+    double average_fragmentation;
+    int failed;             // Set if the configuration could not be run
+} SweepResult;
+
+// Compares two workload line indexes by arrival, keeping file order on ties
+const int *sort_arrivals;
+int compareArrival(const void *a, const void *b)
+{
+    int i = *(const int*)a, j = *(const int*)b;
+    if (sort_arrivals[i] != sort_arrivals[j])
+    {
+        return sort_arrivals[i] - sort_arrivals[j];
+    }
+    return i - j;
+}
+
+/* Reads a workload file into a newly allocated Workload sorted by arrival.
+*  Returns NULL if the file cannot be opened or a line is invalid.
+*/
+Workload* loadWorkload(const char *path)
+{
+    FILE *in = fopen(path, "r");
+    if (in == NULL)
+    {
+        perror("Unable to open workload");
+        return NULL;
+    }
+
+    int capacity = 64, count = 0, line_number = 0;
+    int *arrival = (int*)malloc(capacity * sizeof(int));
+    int *num_bursts = (int*)malloc(capacity * sizeof(int));
+    int (*bursts)[MAX_BURSTS] = malloc(capacity * sizeof(*bursts));
+    long long *memory = (long long*)malloc(capacity * sizeof(long long));
+    char line[512], size[64];
+    while (fgets(line, sizeof(line), in) != NULL)
+    {
+        ++line_number;
+        char *p = line;
+        while (*p == ' ' || *p == '\t') p++;
+        if (*p == '#' || *p == '\n' || *p == '\0')
+        {
+            continue;
+        }
+        if (count == capacity)
+        {
+            capacity *= 2;
+            arrival = (int*)realloc(arrival, capacity * sizeof(int));
+            num_bursts = (int*)realloc(num_bursts, capacity * sizeof(int));
+            bursts = realloc(bursts, capacity * sizeof(*bursts));
+            memory = (long long*)realloc(memory, capacity * sizeof(long long));
+        }
+
+        // arrival, first CPU burst and memory, then any I/O and CPU burst pairs
+        int used = 0, valid;
+        valid = (sscanf(p, "%d %d %63s%n", &arrival[count], &bursts[count][0], size, &used) == 3 &&
+            arrival[count] >= 0 && bursts[count][0] >= 1 &&
+            (memory[count] = parseMemorySize(size)) >= 0);
+        num_bursts[count] = 1;
+        p += used;
+        while (valid && num_bursts[count] < MAX_BURSTS)
+        {
+            char *end;
+            long value = strtol(p, &end, 10);
+            if (end == p)
+            {
+                break;
+            }
+            valid = (value >= 1);
+            bursts[count][num_bursts[count]++] = (int)value;
+            p = end;
+        }
+        while (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n') p++;
+        if (!valid || *p != '\0' || num_bursts[count] % 2 == 0)
+        {
+            printf("Invalid workload line %d: %s", line_number, line);
+            fclose(in);
+            free(arrival);
+            free(num_bursts);
+            free(bursts);
+            free(memory);
+            return NULL;
+        }
+        count++;
+    }
+    fclose(in);
+
+    // Sort by arrival clock so a run only ever looks at the next entry
+    Workload *W = (Workload*)malloc(sizeof(Workload));
+    int i, *order = (int*)malloc((count > 0 ? count : 1) * sizeof(int));
+    for (i = 0; i < count; i++)
+    {
+        order[i] = i;
+    }
+    sort_arrivals = arrival;
+    qsort(order, count, sizeof(int), compareArrival);
+    W->count = count;
+    W->arrival = (int*)malloc((count > 0 ? count : 1) * sizeof(int));
+    W->num_bursts = (int*)malloc((count > 0 ? count : 1) * sizeof(int));
+    W->bursts = malloc((count > 0 ? count : 1) * sizeof(*bursts));
+    W->memory = (long long*)malloc((count > 0 ? count : 1) * sizeof(long long));
+    for (i = 0; i < count; i++)
+    {
+        W->arrival[i] = arrival[order[i]];
+        W->num_bursts[i] = num_bursts[order[i]];
+        memcpy(W->bursts[i], bursts[order[i]], sizeof(*bursts));
+        W->memory[i] = memory[order[i]];
+    }
+    free(order);
+    free(arrival);
+    free(num_bursts);
+    free(bursts);
+    free(memory);
+    return W;
+}
+
+/* Parses a comma separated list of memory sizes (e.g. "1M,4M,64G") into
+*  values. Returns the number parsed, or -1 if any entry is invalid.
+*/
+int parseSizeList(const char *text, long long *values, int max_values)
+{
+    char buffer[1024], *token, *save;
+    int count = 0;
+    snprintf(buffer, sizeof(buffer), "%s", text);
+    for (token = strtok_r(buffer, ",", &save); token != NULL; token = strtok_r(NULL, ",", &save))
+    {
+        if (count == max_values || (values[count] = parseMemorySize(token)) < 1)
+        {
+            return -1;
+        }
+        count++;
+    }
+    return count;
+}
+
+/* Parses a comma separated list of quanta (e.g. "2,4,8") into values. Each
+*  must be a plain positive int. Returns the number parsed, or -1 if any
+*  entry is invalid.
+*/
+int parseQuantumList(const char *text, int *values, int max_values)
+{
+    char buffer[1024], *token, *save, *end;
+    int count = 0;
+    snprintf(buffer, sizeof(buffer), "%s", text);
+    for (token = strtok_r(buffer, ",", &save); token != NULL; token = strtok_r(NULL, ",", &save))
+    {
+        errno = 0;
+        long value = strtol(token, &end, 10);
+        if (count == max_values || end == token || *end != '\0' || errno != 0 || value < 1 || value > INT_MAX)
+        {
+            return -1;
+        }
+        values[count++] = (int)value;
+    }
+    return count;
+}
+
+// Appends value to SampleList L.
+void addSample(SampleList *L, int value)
+{
+    if (L->count == L->capacity)
+    {
+        L->capacity = (L->capacity > 0) ? L->capacity * 2 : 64;
+        L->values = (int*)realloc(L->values, L->capacity * sizeof(int));
+    }
+    L->values[L->count++] = value;
+}
+
+int compareInt(const void *a, const void *b)
+{
+    int x = *(const int*)a, y = *(const int*)b;
+    return (x > y) - (x < y);
+}
+
+/* Returns the nearest-rank percentile (0 to 100) of a sorted SampleList,
+*  or 0 if it is empty.
+*/
+double percentileOf(SampleList *L, double percentile)
+{
+    if (L->count == 0)
+    {
+        return 0.0;
+    }
+    int rank = (int)((percentile / 100.0) * L->count + 0.999999);
+    if (rank < 1) rank = 1;
+    if (rank > L->count) rank = L->count;
+    return L->values[rank - 1];
+}
+
+void printSweepHeader()
+{
+    printf("total_memory,page_size,round_robin,clocks,completed,rejected,context_switches,"
+        "utilization,avg_turnaround,turnaround_p50,turnaround_p90,turnaround_p99,"
+        "avg_wait,avg_fragmentation\n");
+}
+
+void printSweepResult(SweepResult *r)
+{
+    printf("%lld,%lld,%d,%d,%d,%d,%d,%f,%f,%.0f,%.0f,%.0f,%f,%f\n",
+        r->total_memory, r->page_size, r->round_robin, r->clocks, r->completed, r->rejected,
+        r->context_switches, r->utilization, r->average_turnaround, r->turnaround_p50,
+        r->turnaround_p90, r->turnaround_p99, r->average_wait, r->average_fragmentation);
+}
+
+/* Runs simulate once for every combination of the given memory sizes, page
+*  sizes and quanta, with up to jobs configurations in flight at once. Each
+*  one runs in its own forked process and returns its SweepResult through a
+*  pipe. Prints a CSV header and one row per configuration, in grid order;
+*  each configuration which failed is named on stderr instead. Returns the
+*  number of configurations which failed.
+*/
+int runSweep(long long *memories, int num_memories, long long *pages, int num_pages,
+    int *quanta, int num_quanta, int jobs, SweepResult (*simulate)(long long, long long, int))
+{
+    int total = num_memories * num_pages * num_quanta;
+    SweepResult *results = (SweepResult*)calloc(total, sizeof(SweepResult));
+    int *ok = (int*)calloc(total, sizeof(int));
+    pid_t *pids = (pid_t*)calloc(total, sizeof(pid_t));
+    int *pipes = (int*)calloc(total, sizeof(int));
+    int next = 0, running = 0, failed = 0, i;
+
+    fflush(stdout);
+    while (next < total || running > 0)
+    {
+        // Start configurations until jobs are in flight
+        while (next < total && running < jobs)
+        {
+            int fds[2];
+            if (pipe(fds) < 0)
+            {
+                perror("Unable to create sweep pipe");
+                break;
+            }
+            long long memory = memories[next / (num_pages * num_quanta)];
+            long long page = pages[(next / num_quanta) % num_pages];
+            int quantum = quanta[next % num_quanta];
+            pid_t pid = fork();
+            if (pid == 0)
+            {
+                close(fds[0]);
+                SweepResult r = simulate(memory, page, quantum);
+                write(fds[1], &r, sizeof(SweepResult));
+                _exit(0);
+            }
+            close(fds[1]);
+            if (pid < 0)
+            {
+                perror("Unable to fork sweep instance");
+                close(fds[0]);
+                break;
+            }
+            pids[next] = pid;
+            pipes[next] = fds[0];
+            next++;
+            running++;
+        }
+        if (running == 0)
+        {
+            break;
+        }
+
+        // Collect whichever configuration finishes first
+        int status;
+        pid_t done = wait(&status);
+        if (done < 0)
+        {
+            break;
+        }
+        for (i = 0; i < next; i++)
+        {
+            if (pids[i] == done)
+            {
+                ok[i] = (read(pipes[i], &results[i], sizeof(SweepResult)) == sizeof(SweepResult) &&
+                    !results[i].failed);
+                close(pipes[i]);
+                running--;
+                break;
+            }
+        }
+    }
+
+    printSweepHeader();
+    for (i = 0; i < total; i++)
+    {
+        if (ok[i])
+        {
+            printSweepResult(&results[i]);
+        }
+        else
+        {
+            fprintf(stderr, "Configuration %lld,%lld,%d failed.\n", memories[i / (num_pages * num_quanta)],
+                pages[(i / num_quanta) % num_pages], quanta[i % num_quanta]);
+            failed++;
+        }
+    }
+    free(results);
+    free(ok);
+    free(pids);
+    free(pipes);
+    return failed;
+}
+
+#endif
@@ -0,0 +1,215 @@
+/**************************    timing_wheel.h    ***************************
+*
+* Programmer:       Sean Anderson
+*
+* School:           University of Houston - Clear Lake
+*
+* Course:           CSCI 4354 - Operating Systems
+*
+* Environment:      Unix with GNU C Compiler
+*
+* Files Included:   cpu_scheduler.c, pcb_structs.h, timing_wheel.h
+*
+* Purpose:          Header file which contains the TimingWheel that holds PCBs
+*                   blocked on I/O. It is a hierarchical timing wheel: level 0 has
+*                   one slot per clock, and each higher level has one slot per full
+*                   turn of the level below it. Inserting a PCB and expiring one
+*                   clock's worth of PCBs are O(1); PCBs on a higher level are
+*                   cascaded down a level when the lower wheel completes a turn.
+*                   A PCB can also be removed early (cancelled) in O(1).
+*
+***********************************************************************/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include "pcb_structs.h"
+
+#ifndef TIMING_WHEEL_H
+#define TIMING_WHEEL_H
+
+#define WHEEL_BITS 6
+#define WHEEL_SLOTS (1 << WHEEL_BITS)
+#define WHEEL_MASK (WHEEL_SLOTS - 1)
+#define WHEEL_LEVELS 4  // Covers 2^24 clocks ahead
+
+typedef struct wheel_node WheelNode;
+typedef struct timing_wheel TimingWheel;
+
+// wheel_node struct: a blocked PCB, expiring at element.ioCompleteTime
+struct wheel_node
+{
+    PCB element;
+    WheelNode *next;
+    WheelNode **pprev;  // The pointer which points at this node
+};
+
+struct timing_wheel
+{
+    WheelNode *slots[WHEEL_LEVELS][WHEEL_SLOTS];
+    int now;
+    int size;
+};
+
+/** Null constructor for a new TimingWheel starting at clock now. */
+TimingWheel* new_TimingWheel(int now)
+{
+    TimingWheel *W = (TimingWheel*)calloc(1, sizeof(TimingWheel));
+    W->now = now;
+    return W;
+}
+
+// Links node N into the slot for its expiry time relative to W->now.
+void placeWheelNode(TimingWheel *W, WheelNode *N)
+{
+    int expires = N->element.ioCompleteTime;
+    int delta = expires - W->now;
+    int level = 0;
+
+    // Cascaded nodes due this clock land in the slot about to be expired
+    if (delta < 0)
+    {
+        expires = W->now;
+        delta = 0;
+    }
+    while (level < WHEEL_LEVELS - 1 && delta >= (1 << (WHEEL_BITS * (level + 1))))
+    {
+        level++;
+    }
+    // Beyond the top level, park in the farthest slot and cascade again later
+    if (delta >= (1 << (WHEEL_BITS * WHEEL_LEVELS)))
+    {
+        expires = W->now + (1 << (WHEEL_BITS * WHEEL_LEVELS)) - 1;
+    }
+    int slot = (expires >> (WHEEL_BITS * level)) & WHEEL_MASK;
+    N->next = W->slots[level][slot];
+    N->pprev = &W->slots[level][slot];
+    if (N->next != NULL)
+    {
+        N->next->pprev = &N->next;
+    }
+    W->slots[level][slot] = N;
+}
+
+/** Creates a new wheel_node which stores the value of PCB p and
+ *  links it into TimingWheel W to expire at p.ioCompleteTime.
+ *  Returns the new node, which stays valid until it expires. */
+WheelNode* insertTimingWheel(TimingWheel *W, PCB p)
+{
+    WheelNode *N = (WheelNode*)malloc(sizeof(WheelNode));
+    N->element = p;
+    // This clock's slot has already expired, so anything due expires next clock
+    if (N->element.ioCompleteTime <= W->now)
+    {
+        N->element.ioCompleteTime = W->now + 1;
+    }
+    placeWheelNode(W, N);
+    W->size++;
+    return N;
+}
+
+/** Unlinks wheel_node N from TimingWheel W before it expires. Creates
+ *  a PCB with the values from the node and returns a pointer to it. */
+PCB* removeTimingWheel(TimingWheel *W, WheelNode *N)
+{
+    PCB *temp = (PCB*)malloc(sizeof(PCB));
+    *temp = N->element;
+    *N->pprev = N->next;
+    if (N->next != NULL)
+    {
+        N->next->pprev = N->pprev;
+    }
+    free(N);
+    W->size--;
+    return temp;
+}
+
+/** Advances TimingWheel W by one clock. Returns the list of wheel_nodes
+ *  which expire at the new W->now, linked through next, or NULL. The
+ *  caller owns and frees the returned nodes. */
+WheelNode* advanceTimingWheel(TimingWheel *W)
+{
+    int level;
+    W->now++;
+
+    // When a level completes a turn, cascade the next level's current slot down
+    for (level = 1; level < WHEEL_LEVELS; level++)
+    {
+        if ((W->now & ((1 << (WHEEL_BITS * level)) - 1)) != 0)
+        {
+            break;
+        }
+        int slot = (W->now >> (WHEEL_BITS * level)) & WHEEL_MASK;
+        WheelNode *N = W->slots[level][slot];
+        W->slots[level][slot] = NULL;
+        while (N != NULL)
+        {
+            WheelNode *next = N->next;
+            placeWheelNode(W, N);
+            N = next;
+        }
+    }
+
+    WheelNode *expired = NULL, *kept = NULL, *N;
+    N = W->slots[0][W->now & WHEEL_MASK];
+    while (N != NULL)
+    {
+        WheelNode *next = N->next;
+        // A node parked beyond the top level is not due yet
+        if (N->element.ioCompleteTime > W->now)
+        {
+            N->next = kept;
+            kept = N;
+        }
+        else
+        {
+            N->next = expired;
+            expired = N;
+            W->size--;
+        }
+        N = next;
+    }
+    W->slots[0][W->now & WHEEL_MASK] = NULL;
+    while (kept != NULL)
+    {
+        N = kept->next;
+        placeWheelNode(W, kept);
+        kept = N;
+    }
+    return expired;
+}
+
+/** Removes every wheel_node from TimingWheel W, due or not, and returns
+ *  them as a list linked through next. */
+WheelNode* drainTimingWheel(TimingWheel *W)
+{
+    WheelNode *all = NULL;
+    int level, slot;
+    for (level = 0; level < WHEEL_LEVELS; level++)
+    {
+        for (slot = 0; slot < WHEEL_SLOTS; slot++)
+        {
+            while (W->slots[level][slot] != NULL)
+            {
+                WheelNode *N = W->slots[level][slot];
+                W->slots[level][slot] = N->next;
+                N->next = all;
+                all = N;
+            }
+        }
+    }
+    W->size = 0;
+    return all;
+}
+
+// Frees a list of wheel_nodes linked through next.
+void freeWheelNodes(WheelNode *N)
+{
+    while (N != NULL)
+    {
+        WheelNode *next = N->next;
+        free(N);
+        N = next;
+    }
+}
+
+#endif